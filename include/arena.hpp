@@ -0,0 +1,52 @@
+#ifndef EVI_ARENA_H
+#define EVI_ARENA_H
+
+#include "common.hpp"
+#include <vector>
+
+#define ARENA_BLOCK_SIZE (64 * 1024) // bytes
+
+// a bump-pointer allocator owned by a compilation. everything allocated from
+// it is freed at once when it's destroyed, after the registered destructors ran.
+class Arena
+{
+public:
+	Arena(): _current(nullptr), _end(nullptr) {}
+	~Arena();
+	void* allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+	// for objects that own memory outside of the arena (e.g. strings)
+	template<typename T> void add_destructor(T* object)
+	{
+		_destructors.push_back({object, [](void* p) { ((T*)p)->~T(); }});
+	}
+
+private:
+	char* _current;
+	char* _end;
+	vector<char*> _blocks;
+	vector<pair<void*, void (*)(void*)>> _destructors;
+};
+
+// the arena of the compilation running on this thread
+extern thread_local Arena* __arena;
+
+// lets standard containers allocate from the arena of the current thread
+template<typename T> class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator() {}
+	template<typename U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+	T* allocate(size_t n) { return (T*)__arena->allocate(n * sizeof(T), alignof(T)); }
+	void deallocate(T*, size_t) {}
+
+	template<typename U> bool operator==(const ArenaAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+template<typename T> using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -5,6 +5,7 @@
 #include "pch.h"
 #include "types.hpp"
 #include "scanner.hpp"
+#include "arena.hpp"
 
 // =================================================
 
@@ -33,11 +34,34 @@ class StmtNode;
 			class ReferenceNode;
 			class CallNode;
 
-// visitor class
-class Visitor
+// the kind of a node, used to dispatch to visitors
+typedef enum : uint8_t
+{
+	NODE_FUNC_DECL,
+	NODE_VAR_DECL,
+	NODE_ASSIGN,
+	NODE_IF,
+	NODE_LOOP,
+	NODE_RETURN,
+	NODE_BLOCK,
+		NODE_SUBSCRIPT,
+		NODE_LOGICAL,
+		NODE_BINARY,
+		NODE_UNARY,
+		NODE_CAST,
+		NODE_GROUPING,
+			NODE_LITERAL,
+			NODE_ARRAY,
+			NODE_SIZE_OF,
+			NODE_REFERENCE,
+			NODE_CALL,
+} NodeKind;
+
+// visitor class (visit methods return their result directly)
+template<typename R> class Visitor
 {
 	public:
-	#define VISIT(_node) virtual void visit(_node* node) = 0
+	#define VISIT(_node) virtual R visit(_node* node) = 0
 	VISIT(FuncDeclNode);
 	VISIT(VarDeclNode);
 	VISIT(AssignNode);
@@ -59,27 +83,50 @@ class Visitor
 	#undef VISIT
 };
 
+// amount of nodes created by this thread (for --time-phases)
+extern thread_local size_t ast_node_count;
+
+// the tokens of the compilation running on this thread. nodes only need
+// their token for diagnostics, so they keep its index in the buffer.
+extern thread_local const TokenBuffer* __tokens;
+
 // astnode class (visited by visitor)
+// nodes are allocated from the arena of the compilation. they have no vtable,
+// the ones that own memory outside of the arena register their destructor.
 class ASTNode
 {
 	public:
-	ASTNode(Token token): _token(token) {}
-	Token _token;
+	ASTNode(NodeKind kind, Token token): _kind(kind), _token_index(token.index) { ast_node_count++; }
+	static void* operator new(size_t size) { return __arena->allocate(size); }
+	static void operator delete(void* ptr) {}
+
+	NodeKind _kind;
+	uint32_t _token_index;
 	ParsedType* _cast_to;
-	virtual void accept(Visitor* v) = 0;
+
+	Token token() { return __tokens->get(_token_index); }
+	template<typename R> R accept(Visitor<R>* v);
 };
 
 // abstract syntax tree
-typedef vector<StmtNode*> AST;
+typedef ArenaVector<StmtNode*> AST;
+
+// the storage a variable or parameter is bound to by the parser.
+// parameters take the first local slots of their function,
+// its variables the ones after that.
+typedef struct
+{
+	int index;
+	bool global;
+} Slot;
 
 // =================================================
 
-#define ACCEPT void accept(Visitor *v) { v->visit(this); }
-#define VIRTUAL_NODE_DECLARATION(name, base) \
+#define BASE_NODE_DECLARATION(name, base) \
 	class name : public base \
-	{ public: name(Token token): base(token) {} virtual void accept(Visitor *v) = 0; }
+	{ public: name(NodeKind kind, Token token): base(kind, token) {} }
 
-VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
+BASE_NODE_DECLARATION(StmtNode, ASTNode);
 
 	class FuncDeclNode: public StmtNode
 	{
@@ -87,18 +134,18 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 
 		// body = nullptr if only declaration
 		FuncDeclNode(Token token, string identifier, ParsedType* ret_type, bool static_,
-					 vector<ParsedType*> params, bool variadic, StmtNode* body):
-			StmtNode(token), _identifier(identifier), 
+					 ArenaVector<ParsedType*> params, bool variadic, StmtNode* body, int slot_count = 0):
+			StmtNode(NODE_FUNC_DECL, token), _identifier(identifier), 
 			_ret_type(ret_type), _static(static_), _params(params), 
-			_variadic(variadic), _body(body) {}
-		ACCEPT
+			_variadic(variadic), _body(body), _slot_count(slot_count) { __arena->add_destructor(this); }
 
 		string _identifier;
 		ParsedType* _ret_type;
 		bool _static;
-		vector<ParsedType*> _params;
+		ArenaVector<ParsedType*> _params;
 		bool _variadic;
 		StmtNode* _body; // nullptr if only declared
+		int _slot_count; // amount of local slots used by the body
 	};
 
 	class VarDeclNode: public StmtNode
@@ -107,32 +154,32 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 
 		// expr = nullptr if only declaration
 		VarDeclNode(Token token, string identifier, ParsedType* type,
-					bool static_, ExprNode* expr, bool is_global):
-			StmtNode(token), _identifier(identifier), _type(type),
-			_static(static_), _expr(expr), _is_global(is_global) {}
-		ACCEPT
+					bool static_, ExprNode* expr, bool is_global, Slot slot):
+			StmtNode(NODE_VAR_DECL, token), _identifier(identifier), _type(type),
+			_static(static_), _expr(expr), _is_global(is_global), _slot(slot) { __arena->add_destructor(this); }
 
 		string _identifier;
 		ParsedType* _type;
 		bool _static;
 		ExprNode* _expr;
 		bool _is_global;
+		Slot _slot;
 	};
 
 	class AssignNode: public StmtNode
 	{
 		public:
 
-		AssignNode(Token token, string ident, vector<ExprNode*> subscripts,
-				   ExprNode* expr, ParsedType* expected_type):
-			StmtNode(token), _ident(ident), _subscripts(subscripts), 
-			_expr(expr), _expected_type(expected_type) {}
-		ACCEPT
+		AssignNode(Token token, string ident, ArenaVector<ExprNode*> subscripts,
+				   ExprNode* expr, ParsedType* expected_type, Slot slot):
+			StmtNode(NODE_ASSIGN, token), _ident(ident), _subscripts(subscripts), 
+			_expr(expr), _expected_type(expected_type), _slot(slot) { __arena->add_destructor(this); }
 
 		string _ident;
-		vector<ExprNode*> _subscripts;
+		ArenaVector<ExprNode*> _subscripts;
 		ExprNode* _expr;
 		ParsedType* _expected_type;
+		Slot _slot;
 	};
 
 	class IfNode: public StmtNode
@@ -140,9 +187,8 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 		public:
 
 		IfNode(Token token, ExprNode* cond, StmtNode* then, StmtNode* else_):
-			StmtNode(token), _cond(cond), 
+			StmtNode(NODE_IF, token), _cond(cond), 
 			_then(then), _else(else_) {}
-		ACCEPT
 
 		ExprNode* _cond;
 		StmtNode* _then;
@@ -156,9 +202,8 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 		LoopNode(Token token,
 				 StmtNode* init, ExprNode* cond,
 				 StmtNode* incr, StmtNode* body):
-			StmtNode(token), _init(init), _cond(cond),
+			StmtNode(NODE_LOOP, token), _init(init), _cond(cond),
 			_incr(incr), _body(body) {}
-		ACCEPT
 
 		StmtNode* _init;
 		ExprNode* _cond;
@@ -171,8 +216,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 		public:
 
 		ReturnNode(Token token, ExprNode* expr, ParsedType* expected_type):
-			StmtNode(token), _expr(expr), _expected_type(expected_type) {}
-		ACCEPT
+			StmtNode(NODE_RETURN, token), _expr(expr), _expected_type(expected_type) {}
 
 		ExprNode* _expr;
 		ParsedType* _expected_type;
@@ -186,14 +230,13 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 		// just a collection of statements that belong
 		// to the same context rather than a new one
 		BlockNode(Token token, AST statements, bool secret = false):
-			 StmtNode(token), _statements(statements), _secret(secret) {}
-		ACCEPT
+			 StmtNode(NODE_BLOCK, token), _statements(statements), _secret(secret) {}
 
 		AST _statements;
 		bool _secret;
 	};
 
-	VIRTUAL_NODE_DECLARATION(ExprNode, StmtNode);
+	BASE_NODE_DECLARATION(ExprNode, StmtNode);
 
 		class LogicalNode: public ExprNode
 		{
@@ -201,10 +244,10 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 
 			LogicalNode(Token token, ExprNode* left, 
 						ExprNode* right, ExprNode* middle = nullptr):
-				ExprNode(token), _left(left), 
-				_right(right), _middle(middle) {}
-			ACCEPT
+				ExprNode(NODE_LOGICAL, token), _optype(token.type),
+				_left(left), _right(right), _middle(middle) {}
 
+			TokenType _optype;
 			ExprNode* _left;
 			ExprNode* _right;
 			ExprNode* _middle;
@@ -215,8 +258,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			public:
 
 			BinaryNode(Token token, TokenType optype, ExprNode* left, ExprNode* right):
-				ExprNode(token), _optype(optype), _left(left), _right(right) {}
-			ACCEPT
+				ExprNode(NODE_BINARY, token), _optype(optype), _left(left), _right(right) {}
 
 			TokenType _optype;
 			ExprNode* _left;
@@ -228,8 +270,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			public:
 
 			UnaryNode(Token token, TokenType optype, ExprNode* expr):
-				ExprNode(token), _optype(optype), _expr(expr) {}
-			ACCEPT
+				ExprNode(NODE_UNARY, token), _optype(optype), _expr(expr) {}
 
 			TokenType _optype;
 			ExprNode* _expr;
@@ -240,8 +281,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			public:
 
 			CastNode(Token token, ExprNode* expr, ParsedType* type):
-				ExprNode(token), _expr(expr), _type(type) {}
-			ACCEPT
+				ExprNode(NODE_CAST, token), _expr(expr), _type(type) {}
 
 			ExprNode* _expr;
 			ParsedType* _type;
@@ -252,8 +292,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			public:
 
 			GroupingNode(Token token, ExprNode* expr): 
-				ExprNode(token), _expr(expr) {}
-			ACCEPT
+				ExprNode(NODE_GROUPING, token), _expr(expr) {}
 
 			ExprNode* _expr;
 		};
@@ -263,40 +302,43 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			public:
 
 			SubscriptNode(Token token, ExprNode* expr, ExprNode* index): 
-				ExprNode(token), _expr(expr), _index(index) {}
-			ACCEPT
+				ExprNode(NODE_SUBSCRIPT, token), _expr(expr), _index(index) {}
 
 			ExprNode* _expr;
 			ExprNode* _index;
 		};
 
-		VIRTUAL_NODE_DECLARATION(PrimaryNode, ExprNode);
+		BASE_NODE_DECLARATION(PrimaryNode, ExprNode);
 		
 			class LiteralNode: public PrimaryNode
 			{
 				public:
 
-				LiteralNode(Token token, long value): PrimaryNode(token) { _int_value = value; }
-				LiteralNode(Token token, double value): PrimaryNode(token) { _float_value = value; }
-				LiteralNode(Token token, char value): PrimaryNode(token) { _char_value = value; }
-				LiteralNode(Token token, string value): PrimaryNode(token) { _string_value = value; }
-				ACCEPT
-
-				long _int_value;
-				double _float_value;
-				char _char_value;
-				string _string_value;
+				LiteralNode(Token token, long value): PrimaryNode(NODE_LITERAL, token), _literal_type(token.type) { _int_value = value; }
+				LiteralNode(Token token, double value): PrimaryNode(NODE_LITERAL, token), _literal_type(token.type) { _float_value = value; }
+				LiteralNode(Token token, char value): PrimaryNode(NODE_LITERAL, token), _literal_type(token.type) { _char_value = value; }
+				// the string points into the source (without quotes and unescaped)
+				LiteralNode(Token token, ccp value, int length): PrimaryNode(NODE_LITERAL, token), _literal_type(token.type)
+					{ _string_value = {value, length}; }
+
+				TokenType _literal_type; // decides which value is set
+				union
+				{
+					long _int_value;
+					double _float_value;
+					char _char_value;
+					struct { ccp start; int length; } _string_value;
+				};
 			};
 
 			class ArrayNode: public PrimaryNode
 			{
 				public:
 
-				ArrayNode(Token token, vector<ExprNode*> elements):
-					PrimaryNode(token), _elements(elements) {}
-				ACCEPT
+				ArrayNode(Token token, ArenaVector<ExprNode*> elements):
+					PrimaryNode(NODE_ARRAY, token), _elements(elements) {}
 
-				vector<ExprNode*> _elements;
+				ArenaVector<ExprNode*> _elements;
 			};
 
 			class SizeOfNode : public PrimaryNode
@@ -304,8 +346,7 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 				public:
 
 				SizeOfNode(Token token, ParsedType* type):
-					PrimaryNode(token), _type(type) {}
-				ACCEPT
+					PrimaryNode(NODE_SIZE_OF, token), _type(type) {}
 
 				ParsedType* _type;
 			};
@@ -314,32 +355,62 @@ VIRTUAL_NODE_DECLARATION(StmtNode, ASTNode);
 			{
 				public:
 
-				ReferenceNode(Token token, string var, int par, ParsedType* type):
-					PrimaryNode(token), _variable(var), _parameter(par), _type(type) {}
-				ACCEPT
+				ReferenceNode(Token token, string var, int par, ParsedType* type, Slot slot):
+					PrimaryNode(NODE_REFERENCE, token), _variable(var), _parameter(par), _type(type), _slot(slot)
+					{ __arena->add_destructor(this); }
 
 				string _variable;
 				int _parameter;
 				ParsedType* _type;
+				Slot _slot;
 			};
 
 			class CallNode: public PrimaryNode
 			{
 				public:
 
-				CallNode(Token token, string ident, vector<ExprNode*> arguments, ParsedType* ret_t_type,
-						 vector<ParsedType*> expected_arg_types, int func_params_count):
-					PrimaryNode(token), _ident(ident), _arguments(arguments),
+				CallNode(Token token, string ident, ArenaVector<ExprNode*> arguments, ParsedType* ret_t_type,
+						 ArenaVector<ParsedType*> expected_arg_types, int func_params_count):
+					PrimaryNode(NODE_CALL, token), _ident(ident), _arguments(arguments),
 					_ret_type(ret_t_type), _expected_arg_types(expected_arg_types),
-					_func_params_count(func_params_count) {}
-				ACCEPT
+					_func_params_count(func_params_count) { __arena->add_destructor(this); }
 
 				string _ident;
-				vector<ExprNode*> _arguments;
+				ArenaVector<ExprNode*> _arguments;
 				ParsedType* _ret_type;
-				vector<ParsedType*> _expected_arg_types;
+				ArenaVector<ParsedType*> _expected_arg_types;
 				int _func_params_count;
 			};
 
-#undef ACCEPT
+// =================================================
+
+template<typename R> R ASTNode::accept(Visitor<R>* v)
+{
+	#define DISPATCH(_kind, _node) case _kind: return v->visit(static_cast<_node*>(this))
+	switch(_kind)
+	{
+		DISPATCH(NODE_FUNC_DECL, FuncDeclNode);
+		DISPATCH(NODE_VAR_DECL, VarDeclNode);
+		DISPATCH(NODE_ASSIGN, AssignNode);
+		DISPATCH(NODE_IF, IfNode);
+		DISPATCH(NODE_LOOP, LoopNode);
+		DISPATCH(NODE_RETURN, ReturnNode);
+		DISPATCH(NODE_BLOCK, BlockNode);
+			DISPATCH(NODE_SUBSCRIPT, SubscriptNode);
+			DISPATCH(NODE_LOGICAL, LogicalNode);
+			DISPATCH(NODE_BINARY, BinaryNode);
+			DISPATCH(NODE_UNARY, UnaryNode);
+			DISPATCH(NODE_CAST, CastNode);
+			DISPATCH(NODE_GROUPING, GroupingNode);
+				DISPATCH(NODE_LITERAL, LiteralNode);
+				DISPATCH(NODE_ARRAY, ArrayNode);
+				DISPATCH(NODE_SIZE_OF, SizeOfNode);
+				DISPATCH(NODE_REFERENCE, ReferenceNode);
+				DISPATCH(NODE_CALL, CallNode);
+	}
+	#undef DISPATCH
+	THROW_INTERNAL_ERROR("during AST traversal");
+	return R();
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef EVI_CACHE_H
+#define EVI_CACHE_H
+
+#include "common.hpp"
+#include "pch.h"
+
+#define CACHE_DIR_ENV "EVI_CACHE_DIR"
+#define CACHE_ENTRY_MAGIC "evi-cache2"
+
+typedef struct
+{
+	bool disabled;
+	bool print_stats;
+} cache_args_t;
+
+extern cache_args_t cache_args;
+
+// a cached compilation artifact (an object or llvm IR)
+typedef struct
+{
+	string data;
+	bool has_main;
+	string diagnostics; // the warnings printed while compiling it
+} CacheEntry;
+
+class SourceMap;
+
+// the key of a compilation of the given preprocessed source and its source
+// map with the given options (optimization level, target, output kind, etc.)
+string cache_key(ccp source, const SourceMap* map, string options);
+
+// returns true and fills in the entry if the key is cached
+bool cache_lookup(string key, CacheEntry* entry);
+// caches the artifact (an emitted file) under the key
+void cache_store(string key, ccp artifact, bool has_main, string diagnostics);
+// caches the artifact (still in memory) under the key
+void cache_store_data(string key, string data, bool has_main, string diagnostics);
+
+// prints the hit and miss counts (--cache-stats)
+void cache_report();
+
+#endif
@@ -9,6 +9,8 @@
 
 #include <stack>
 
+#define DEFAULT_TARGET_CPU "generic"
+
 typedef enum
 {
 	OPTIMIZE_O0 = '0',
@@ -20,19 +22,58 @@ typedef enum
 	OPTIMIZE_Oz = 'z',
 } OptimizationType;
 
-class CodeGenerator: public Visitor
+typedef enum
+{
+	LTO_NONE,
+	LTO_STDLIB, 		// only the stdlib is internalized
+	LTO_WHOLE_PROGRAM, 	// everything but main is internalized
+} LTOType;
+
+typedef enum
+{
+	PIPELINE_PER_MODULE,
+	PIPELINE_LTO_PRE_LINK,
+	PIPELINE_LTO,
+} PipelineType;
+
+typedef struct
+{
+	bool generate;
+	ccp generate_file; // profile the instrumented program writes (or nullptr for the default)
+	ccp use_file; // .profdata file to optimize with (or nullptr)
+} pgo_args_t;
+
+extern pgo_args_t pgo_args;
+
+class CodeGenerator: public Visitor<llvm::Value*>
 {
 public:
-	CodeGenerator();
+	CodeGenerator(string cpu = DEFAULT_TARGET_CPU, string features = "", int codegen_threads = 1);
 	Status generate(ccp infile, ccp outfile, ccp source,
-					AST* astree, OptimizationType opt, bool debug_info);
+					AST* astree, OptimizationType opt, bool debug_info, LTOType lto);
 
 	Status emit_llvm(ccp filename);
 	Status emit_object(ccp filename);
-	Status emit_binary(ccp filename, ccp* linked, int linkedc);
+	// resolves 'native' as cpu and/or features to those of the host
+	static void resolve_target(string* cpu, string* features);
+
+	// emits the object into anonymous in-memory files (more than one if the
+	// module is split up for parallel codegen) and gives their paths
+	Status emit_object_in_memory(vector<string>* paths);
+	// writes an already emitted object to an anonymous in-memory file
+	static Status write_memory_object(ccp name, llvm::StringRef object, string* path);
+	// links the given object files (e.g. from emit_object) into an executable
+	// with the embedded lld, or by invoking LD_PATH if external_ld is set
+	static Status emit_binary(ccp filename, ccp* objects, int objectsc,
+							  ccp* linked, int linkedc, bool external_ld);
+	// emits the module as llvm bitcode (for run_jit)
+	Status emit_bitcode_in_memory(string* bitcode);
+	// runs main from the given bitcode modules in the (lazy) jit with args as argv
+	static Status run_jit(vector<string>* bitcodes, ccp* linked, int linkedc,
+						  vector<string> args, int* exitcode);
 
 	#pragma region visitors
-	#define VISIT(_node) void visit(_node* node)
+	#define VISIT(_node) llvm::Value* visit(_node* node)
 	VISIT(FuncDeclNode);
 	VISIT(VarDeclNode);
 	VISIT(AssignNode);
@@ -57,7 +98,14 @@ public:
 private:
 	void prepare();
 	void optimize();
+	void link_stdlib();
+	void run_pass_pipeline(PipelineType pipeline);
 	void finish();
+	bool add_emit_passes_and_run(llvm::raw_pwrite_stream& dest);
+	void emit_partitions(vector<llvm::SmallVector<char, 0>>* buffers);
+	Status link_partitions(ccp outfile, vector<string>* partitions);
+	static Status resolve_jit_libraries(ccp* linked, int linkedc, vector<string>* libraries);
+	llvm::TargetMachine* create_target_machine();
 
 	char* _infile;
 	char* _outfile;
@@ -71,22 +119,26 @@ private:
 	#endif
 	llvm::TargetMachine* _target_machine;
 	string _target_triple;
+	string _target_cpu;
+	string _target_features;
+	int _codegen_threads;
 	unique_ptr<llvm::Module> _top_module;
 
-	stack<llvm::Value*>* _value_stack;
 	map<string, llvm::Function*> _functions;
-	map<string, pair<llvm::Value*, ParsedType*>> _named_values;
+	// storage of the slots variables and parameters were bound to
+	vector<pair<llvm::Value*, ParsedType*>> _global_slots;
+	vector<pair<llvm::Value*, ParsedType*>> _local_slots;
 	uint _string_literal_count;
 
 	DebugInfoBuilder* _debug_info_builder;
 	bool _build_debug_info;
 	OptimizationType _opt_level;
+	LTOType _lto;
 
-	void error_at(Token *token, string message);
-	void warning_at(Token *token, string message);
+	void error_at(Token token, string message);
+	void warning_at(Token token, string message);
 
-	void push(llvm::Value* value);
-	llvm::Value* pop();
+	pair<llvm::Value*, ParsedType*>& get_slot(Slot slot);
 
 	llvm::AllocaInst* create_entry_block_alloca(llvm::Type* ty, string name);
 	llvm::Value* to_bool(llvm::Value* value);
@@ -72,7 +72,6 @@ More information at %s.\nBuild: %s %s on %s (%s)."
 // macros
 #pragma region
 #define STRINGIFY(value) #value
-#define LINE_MARKER_REGEX " ([0-9]+) \"(.+)\""
 // #define FLAG_MARKER_REGEX " f ([0-9]+)"
 
 #ifdef DEBUG
@@ -109,7 +108,9 @@ More information at %s.\nBuild: %s %s on %s (%s)."
 
 // llvm stuff
 #define LLVM_MODULE_TOP_NAME "top"
-#define TEMP_OBJ_FILE_TEMPLATE "%s.%d.o" // format: sourcefile name and timestamp
+#define TEMP_OBJ_FILE_TEMPLATE "%s.XXXXXX.o" // format: sourcefile name (XXXXXX is made unique)
+#define TEMP_OBJ_FILE_SUFFIX_LEN 2 // length of ".o"
+#define MEMORY_OBJ_FILE_TEMPLATE "/proc/self/fd/%d" // format: memfd file descriptor
 
 // internal shit
 #pragma region
@@ -121,8 +122,14 @@ More information at %s.\nBuild: %s %s on %s (%s)."
 #ifndef STATICLIB_DIR
 #error "STATICLIB_DIR must be defined! (e.g. \"/usr/lib/\")"
 #endif
+// stdlib bitcode (in STATICLIB_DIR) for lto
+#define STDLIB_BITCODE_FILE "libevi.bc"
 // ld args
 #include "ld_args.h"
+// llvm profile runtime (for --profile-generate)
+#ifndef PROFILE_RT_LIB
+#define PROFILE_RT_LIB ""
+#endif
 // stdlib headers directory
 #ifndef STDLIB_DIR
 #error "STDLIB_DIR must be defined! (e.g. \"/usr/share/evi/\")"
@@ -3,6 +3,13 @@
 
 #include "scanner.hpp"
 
+// while set, everything the dispatchers of this thread print is also
+// appended to it (so that a cached compilation can print it again)
+extern thread_local string* __diagnostics;
+
+// prints the text to stderr and records it
+void print_diagnostic(string text);
+
 class ErrorDispatcher
 {
     private:
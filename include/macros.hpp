@@ -9,8 +9,8 @@ class State
 
 	State() {}
 
-	inline static Preprocessor* _p;
-	inline static bool _initialized;
+	inline static thread_local Preprocessor* _p;
+	inline static thread_local bool _initialized;
 
 public:
 
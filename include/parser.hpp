@@ -6,6 +6,7 @@
 #include "error.hpp"
 #include "common.hpp"
 #include "lint.hpp"
+#include "symbols.hpp"
 
 #include "pch.h"
 
@@ -13,47 +14,33 @@ using namespace std;
 
 // ==== ============= ====
 
+// binding power of infix operators, lowest first
+typedef enum
+{
+	PREC_NONE,
+	PREC_TERNARY,		// ?:
+	PREC_LOGICAL_OR,	// ||
+	PREC_LOGICAL_XOR,	// ^^
+	PREC_LOGICAL_AND,	// &&
+	PREC_BITWISE_OR,	// |
+	PREC_BITWISE_XOR,	// ^
+	PREC_BITWISE_AND,	// &
+	PREC_EQUALITY,		// == /=
+	PREC_COMPARISON,	// > >= < <=
+	PREC_SHIFT,			// << >>
+	PREC_TERM,			// + -
+	PREC_FACTOR,		// * /
+	PREC_CAST,			// ->
+} Precedence;
+
 class Parser
 {
 public:
-	Parser(): _scope_stack() {}
-	Status parse(string infile, ccp source, AST* astree);
+	Parser() {}
+	Status parse(string infile, const TokenBuffer* tokens, AST* astree);
 
 private:
 
-	// types
-
-	typedef struct
-	{
-		ParsedType* ret_type;
-		vector<ParsedType*> params;
-		bool variadic;
-		bool defined;
-		bool invalid = false;
-		Token token;
-	} FuncProperties;
-
-	typedef struct
-	{
-		ParsedType* type;
-		Token token;
-	} VarProperties;
-
-	typedef struct
-	{
-		int depth;
-		map<string, VarProperties> variables;
-		FuncProperties func_props;
-		map<string, FuncProperties> functions;
-		
-		enum ScopeType
-		{
-			SCOPE_NORMAL,
-			SCOPE_FUNCTION,
-			SCOPE_LOOP
-		} scope_type;
-	} Scope;
-
 	// methods
 
 	void error_at(Token *token, string message);
@@ -72,11 +59,11 @@ private:
 
 	void generate_lint();
 
-	VarProperties get_variable_props(string name);
-	FuncProperties get_function_props(string name);
+	VarProperties* get_variable_props(string name);
+	FuncProperties* get_function_props(string name);
 	bool check_variable(string name);
 	bool check_function(string name);
-	void add_variable(Token* identtoken, ParsedType* type);
+	Slot add_variable(Token* identtoken, ParsedType* type);
 	void add_function(Token* identtoken, FuncProperties properties);
 	void scope_up();
 	void scope_down();
@@ -93,19 +80,7 @@ private:
 		StmtNode* block_statement();
 		StmtNode* expression_statement();
 			ExprNode* expression(bool = false);
-			ExprNode* ternary(bool);
-			ExprNode* logical_or(bool);
-			ExprNode* logical_xor(bool);
-			ExprNode* logical_and(bool);
-			ExprNode* bitwise_or(bool);
-			ExprNode* bitwise_xor(bool);
-			ExprNode* bitwise_and(bool);
-			ExprNode* equality(bool);
-			ExprNode* comparison(bool);
-			ExprNode* bitwise_shift(bool);
-			ExprNode* term(bool);
-			ExprNode* factor(bool);
-			ExprNode* cast(bool);
+			ExprNode* binary(Precedence, bool);
 			ExprNode* unary(bool);
 			ExprNode* subscript(bool);
 			ExprNode* primary(bool);
@@ -118,13 +93,17 @@ private:
 
 	// members
 
-	Scanner _scanner;
+	const TokenBuffer* _tokens;
+	size_t _next_token;
 	Token _current;
 	Token _previous;
 
 	AST* _astree;
-	vector<Scope> _scope_stack;
-	Scope _current_scope;
+	SymbolTable _symbols;
+	// nullptr outside of function bodies
+	FuncProperties* _current_function;
+	int _global_slots;
+	int _local_slots;
 
 	bool _had_error;
 	bool _panic_mode;
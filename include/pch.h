@@ -20,14 +20,31 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+
+#include <llvm/CodeGen/ParallelCG.h>
 
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+
 #include <llvm/Config/llvm-config.h>
 #include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <llvm/Linker/Linker.h>
 #include "llvm/Passes/PassBuilder.h"
 
+#include <lld/Common/Driver.h>
+
 #include <string>
 #include <cassert>
 #include <iostream>
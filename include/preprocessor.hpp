@@ -5,6 +5,7 @@
 #include "error.hpp"
 #include "lint.hpp"
 #include "scanner.hpp"
+#include <unordered_map>
 
 extern int include_paths_count;
 extern char* include_paths[MAX_INCLUDE_PATHS];
@@ -18,7 +19,7 @@ public:
 		_current_file(),
 		_had_error(false),
 		_error_dispatcher() {}
-	Status preprocess(string infile, ccp* source);
+	Status preprocess(string infile, ccp* source, SourceMap* map);
 
 private:
 
@@ -69,6 +70,13 @@ private:
 		PRAGMA_NO_NEWLINE,
 	} PragmaStatus;
 
+	typedef struct
+	{
+		bool in_block_comment = false;
+		bool in_string = false;
+		bool in_character = false;
+	} CommentState;
+
 	#pragma endregion
 
 	// macros
@@ -77,16 +85,19 @@ private:
 	#define ERROR_F(lineno, line, format, ...) { error_at_line(lineno, tools::fstr(format, __VA_ARGS__).c_str(), line); }
 	#define WARNING(lineno, line, msg) { warning_at_line(lineno, msg, line); }
 	#define WARNING_F(lineno, line, format, ...) { warning_at_line(lineno, tools::fstr(format, __VA_ARGS__).c_str(), line); }
-	#define MACRO_INVOKE_REGEX "([a-zA-Z_][a-zA-Z0-9_]*)#"
+	#define MAX_MACRO_EXPANSION_DEPTH 255
 	#pragma endregion
 
 	// methods
 	#pragma region methods
 	void initialize_builtin_macros();
 
-	void process_lines(vector<string> lines);
+	void process_lines(ccp start, ccp end);
+	void submit_line(ccp line, size_t length);
+	void submit_line(string line);
 	string handle_plain_line(string line);
-	vector<string> remove_comments(vector<string> lines);
+	bool expand_macros(ccp start, ccp end, string* dest, string& line, uint depth);
+	void remove_comments(string& line, CommentState* state);
 
 	void error_at_line(uint line, ccp message, string whole_line = "");
 	void error_at_token(Token* token, ccp message);
@@ -135,13 +146,17 @@ private:
 	// members
 	#pragma region members
 	ccp _source;
-	vector<string> _lines;
+	char* _output;
+	size_t _output_length;
+	size_t _output_capacity;
+	SourceMap* _source_map;
 	string _current_file;
 	uint _current_line_no;
 	string _current_original_line;
 
 	vector<string> _flags;
-	map<string, MacroProperties>* _macros;
+	unordered_map<string, MacroProperties>* _macros;
+	string _macro_name;
 	stack<bool>* _branches;
 	
 	vector<string> _blocked_files;
@@ -4,7 +4,10 @@
 #include "types.hpp"
 
 #include <vector>
+#include <deque>
 #include <string>
+#include <algorithm>
+#include <memory>
 
 typedef enum
 {
@@ -68,30 +71,92 @@ typedef enum
 	TOKEN_TYPE,
 
 	// misc.
-	TOKEN_LINE_MARKER,
 	TOKEN_ERROR,
 	TOKEN_EOF
 } TokenType;
 
 char *get_tokentype_str(TokenType type);
 
+// the offsets at which the lines of a source start, recorded
+// while scanning so that they can be found by binary search
+class LineIndex
+{
+public:
+	LineIndex(): _starts(1, 0) {}
+	void add_line(ptrdiff_t start) { _starts.push_back(start); }
+
+	// returns the offset of the start of the line containing offset
+	ptrdiff_t find_line_start(ptrdiff_t offset) const
+	{
+		return *(upper_bound(_starts.begin(), _starts.end(), offset) - 1);
+	}
+
+private:
+	vector<ptrdiff_t> _starts;
+};
+
+// the names of the files a compilation's tokens come from. every name is
+// stored once and lives as long as the table, so tokens share their file.
+class FileTable
+{
+public:
+	string* intern(const char *name, size_t length);
+
+private:
+	deque<string> _names; // never moves its elements
+	string* _last = nullptr;
+};
+
+extern thread_local FileTable* __files;
+
+// a run of preprocessed lines that come from the same file. the run
+// starts at an offset in the output with the given line of the file.
+typedef struct
+{
+	uint32_t offset;
+	uint32_t file;
+	uint32_t line;
+} SourceRun;
+
+// where the lines of the preprocessor's output come from, built
+// alongside the output instead of writing line markers into it
+class SourceMap
+{
+public:
+	void add_run(size_t offset, const string& file, uint line);
+	const vector<SourceRun>& get_runs() const { return _runs; }
+	const vector<string>& get_files() const { return _files; }
+
+	// the output with the runs written out as '# N "file"' line markers
+	string insert_markers(const char *output) const;
+
+private:
+	vector<SourceRun> _runs;
+	vector<string> _files;
+};
+
 typedef struct
 {
 	TokenType type;
+	uint32_t index; // in its TokenBuffer (fills the padding after type)
 	const char *source;
 	const char *start;
 	int length;
 	int line;
 	string* file;
+	const LineIndex* lines; // null if the source wasn't scanned
+	EviType* evi_type; // only set for TOKEN_TYPE
 } Token;
 
 class Scanner
 {
 public:
 	Scanner();
-	Scanner(const char *source);
+	Scanner(const char *source, const SourceMap* map = nullptr);
 	Token scanToken();
 	int getScannedLength();
+	// hands the line index over, e.g. to the TokenBuffer that outlives the scanner
+	unique_ptr<LineIndex> takeLineIndex();
 
 private:
 	const char *_src_start;	
@@ -100,6 +165,11 @@ private:
 	int _line;
 
 	string* _filename;
+	unique_ptr<LineIndex> _lines;
+
+	const SourceMap* _map;
+	vector<string*> _map_files;
+	size_t _next_run;
 
 	bool isAtEnd();
 	bool isDigit(char c);
@@ -114,24 +184,62 @@ private:
 	Token character();
 	Token number();
 	Token reference();
-	Token directive();
 	Token type_or_identifier();
 	void skipWhitespaces();
+	void newLine();
+	void enterRuns(ptrdiff_t offset);
+};
+
+// all tokens of a source, scanned up front into parallel arrays.
+// offsets are into the source (or into the messages for error tokens)
+// and files are ids into the file table.
+// type tokens store their BuiltinType instead of the length it implies.
+class TokenBuffer
+{
+public:
+	TokenBuffer() {}
+	TokenBuffer(const char *source, const SourceMap* map = nullptr);
+
+	// the last token is always EOF, indices past it return it again
+	Token get(size_t index) const;
+	size_t size() const { return _types.size(); }
+
+private:
+	void push(Token token);
+
+	const char *_source;
+	unique_ptr<LineIndex> _lines;
+
+	vector<uint8_t> _types;
+	vector<uint32_t> _offsets;
+	vector<uint32_t> _lengths;
+	vector<uint32_t> _linenos;
+	vector<uint32_t> _files;
+
+	vector<string*> _filetable;
+	vector<const char*> _messages;
 };
 
 void print_tokens_from_src(const char *src);
 
-static uint get_token_col(Token* token, int tab_width = -1)
+static ptrdiff_t get_token_line_start(Token* token)
 {
-	if(token->type == TOKEN_ERROR) return 0;
-	
 	// get offset of token (first char)
 	ptrdiff_t token_offset = token->start - token->source;
+	if(token->lines) return token->lines->find_line_start(token_offset);
 
 	// find first newline before token
 	ptrdiff_t tok_ln_begin = token_offset;
 	while(tok_ln_begin > 0 && token->source[tok_ln_begin] != '\n') tok_ln_begin--;
-	tok_ln_begin++; // skip newline itself
+	return tok_ln_begin + 1; // skip newline itself
+}
+
+static uint get_token_col(Token* token, int tab_width = -1)
+{
+	if(token->type == TOKEN_ERROR) return 0;
+	
+	ptrdiff_t token_offset = token->start - token->source;
+	ptrdiff_t tok_ln_begin = get_token_line_start(token);
 
 	ptrdiff_t col = (token_offset - tok_ln_begin);
 
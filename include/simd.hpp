@@ -0,0 +1,28 @@
+#ifndef EVI_SIMD_H
+#define EVI_SIMD_H
+
+#include "common.hpp"
+
+// overrides the variant ("scalar", "sse2" or "avx2"), e.g. to compare them
+#define SIMD_ENV "EVI_SIMD"
+
+// kernels for the scanner's hot loops that classify 16 (sse2) or 32 (avx2)
+// bytes at once. the variant is selected for the cpu by a static initializer
+// at startup and there is a scalar fallback. the null-terminated kernels only
+// use aligned loads, so they never read past the aligned block that holds the
+// terminator. they pay off on long identifiers, strings and indentation.
+namespace simd {
+
+    // first char that isn't ' ', '\t' or '\r'
+    ccp skip_blanks(ccp str);
+    // first char that isn't alphanumeric or '_'
+    ccp skip_identifier(ccp str);
+    // first '"', '\\', '\n' or '\0'
+    ccp find_string_special(ccp str);
+    // first '\\', '#', '"' or '\'' in [str, end), or end
+    ccp find_line_special(ccp str, ccp end);
+
+    // "avx2", "sse2" or "scalar"
+    ccp get_isa();
+}
+#endif
@@ -0,0 +1,86 @@
+#ifndef EVI_SYMBOLS_H
+#define EVI_SYMBOLS_H
+
+#include "common.hpp"
+#include "scanner.hpp"
+#include "types.hpp"
+#include "ast.hpp"
+
+#include <deque>
+#include <vector>
+
+// ==== ============= ====
+
+typedef struct
+{
+	ParsedType* ret_type;
+	vector<ParsedType*> params;
+	bool variadic;
+	bool defined;
+	bool invalid = false;
+	Token token;
+} FuncProperties;
+
+typedef struct
+{
+	ParsedType* type;
+	Token token;
+	Slot slot;
+} VarProperties;
+
+// the declarations visible to the parser. every identifier is interned once
+// into an open-addressing table and points to its innermost declarations.
+// declaring logs the shadowed declaration, so leaving a scope only undoes
+// what was declared in it.
+class SymbolTable
+{
+public:
+	SymbolTable();
+
+	// return nullptr if not found
+	VarProperties* get_variable(string name);
+	FuncProperties* get_function(string name);
+
+	VarProperties* add_variable(string name, VarProperties properties);
+	FuncProperties* add_function(string name, FuncProperties properties);
+
+	void scope_up();
+	void scope_down();
+	int depth();
+
+	// all visible declarations, innermost first
+	vector<pair<string, VarProperties*>> get_variables();
+	vector<pair<string, FuncProperties*>> get_functions();
+
+private:
+	typedef struct
+	{
+		string name;
+		size_t hash;
+		VarProperties* variable;
+		FuncProperties* function;
+	} Identifier;
+
+	typedef struct
+	{
+		Identifier* identifier;
+		// the declaration it shadows, the new one is the top of its storage
+		VarProperties* variable;
+		FuncProperties* function;
+		bool is_function;
+	} Declaration;
+
+	Identifier* intern(string& name, bool insert);
+	void grow();
+
+	deque<Identifier> _identifiers;
+	vector<Identifier*> _slots;
+
+	// declarations are undone in reverse, so their storage is a stack too
+	deque<VarProperties> _variables;
+	deque<FuncProperties> _functions;
+	vector<Declaration> _log;
+	vector<size_t> _scope_starts;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef EVI_TIMING_H
+#define EVI_TIMING_H
+
+#include "common.hpp"
+#include "pch.h"
+
+#define TIME_TRACE_GRANULARITY 0 // microseconds, 0 records every span
+
+typedef struct
+{
+	bool time_phases;
+	bool json; // --time-phases=json
+	ccp trace_file;
+} timing_args_t;
+
+extern timing_args_t timing_args;
+
+// measures the wall time, cpu time and the process' max rss so far at the
+// end of a compilation phase (--time-phases) and records it as a span in
+// the time trace (--time-trace). stops when it goes out of scope.
+class PhaseTimer
+{
+public:
+	PhaseTimer(ccp phase, string file);
+	~PhaseTimer() { stop(); }
+	void stop();
+	// the amount of work done (e.g. tokens) for the throughput
+	void count(long units, ccp unit) { _units = units; _unit = unit; }
+
+private:
+	ccp _phase;
+	string _file;
+	bool _running;
+	double _wall_start;
+	double _cpu_start;
+	long _units;
+	ccp _unit;
+};
+
+// records a (nested) span in the time trace for the rest of the scope
+#define TIME_TRACE_SCOPE(name, detail) \
+	llvm::TimeTraceScope __time_trace_scope(name, [&]() { return string(detail); })
+
+// records a span in the time trace for every llvm pass that is run
+void timing_register_pass_callbacks(llvm::PassInstrumentationCallbacks* callbacks);
+
+// each thread that records spans has to be initialized and finished
+void timing_initialize_thread();
+void timing_finish_thread();
+
+// prints the phase timings and/or writes the time trace
+Status timing_report();
+
+#endif
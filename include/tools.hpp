@@ -20,6 +20,9 @@ namespace tools {
     // file ops
     int execbin(const char* executable, const char** argv);
     string readf(string path);
+    const char* mapf(string path, size_t* size);
+    void unmapf(const char* buffer, size_t size);
     void writef(string path, string text);
+    string mktempf(string templ, int suffixlen);
 }
 #endif
\ No newline at end of file
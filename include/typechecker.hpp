@@ -6,14 +6,12 @@
 #include "ast.hpp"
 #include "lint.hpp"
 
-#include <stack>
-
-class TypeChecker: public Visitor
+class TypeChecker: public Visitor<ParsedType*>
 {
 	public:
 	Status check(string path, ccp source, AST* astree);
 
-	#define VISIT(_node) void visit(_node* node)
+	#define VISIT(_node) ParsedType* visit(_node* node)
 	VISIT(FuncDeclNode);
 	VISIT(VarDeclNode);
 	VISIT(AssignNode);
@@ -38,16 +36,11 @@ class TypeChecker: public Visitor
 	string _infile;
 	ErrorDispatcher _error_dispatcher;
 
-	void error_at(Token *token, string message);
-	void warning_at(Token *token, string message, bool print_token = false);
-
-	// bc the visitor methods return void we instead
-	// just use a stack for the stuff
-	stack<ParsedType*> _type_stack;
-	void push(ParsedType* type);
-	ParsedType* pop();
+	void error_at(Token token, string message);
+	void warning_at(Token token, string message, bool print_token = false);
 
 	ParsedType* resolve_types(ParsedType* left, ParsedType* right);
+	ParsedType* comparison_type(ParsedType* left, ParsedType* right);
 	bool can_cast_types(ParsedType* from, ParsedType* to);
 
 	bool _panic_mode;
@@ -4,6 +4,7 @@
 #include "common.hpp"
 #include "pch.h"
 #include "size.h"
+#include "arena.hpp"
 
 #include <algorithm>
 #include <map>
@@ -47,34 +48,124 @@ public:
 
 // ================================
 
-extern llvm::LLVMContext __context;
-extern map<string, EviType*> __evi_types;
-static bool __evi_builtin_types_initialized = false;
+// the builtin types, in the order of builtin_type_names
+typedef enum
+{
+	BUILTIN_I1,
+	BUILTIN_I4,		BUILTIN_UI4,
+	BUILTIN_I8,		BUILTIN_UI8,
+	BUILTIN_I16,	BUILTIN_UI16,
+	BUILTIN_I32,	BUILTIN_UI32,
+	BUILTIN_I64,	BUILTIN_UI64,
+	BUILTIN_I128,	BUILTIN_UI128,
+	BUILTIN_FLT,	BUILTIN_DBL,
+	BUILTIN_SZE,	BUILTIN_BLN,	BUILTIN_CHR,	BUILTIN_NLL,
+
+	BUILTIN_TYPE_COUNT,
+	BUILTIN_NONE = -1
+} BuiltinType;
+
+constexpr ccp builtin_type_names[BUILTIN_TYPE_COUNT] = {
+	"i1",
+	"i4",	"ui4",
+	"i8",	"ui8",
+	"i16",	"ui16",
+	"i32",	"ui32",
+	"i64",	"ui64",
+	"i128",	"ui128",
+	"flt",	"dbl",
+	"sze",	"bln",	"chr",	"nll",
+};
+
+// picks the only builtin type that could match by the length and
+// first (or last) chars of name, then compares the whole name
+constexpr BuiltinType find_builtin_type(ccp name, size_t length)
+{
+	BuiltinType candidate = BUILTIN_NONE;
+	switch(length)
+	{
+		case 2: if(name[0] == 'i') switch(name[1])
+		{
+			case '1': candidate = BUILTIN_I1; break;
+			case '4': candidate = BUILTIN_I4; break;
+			case '8': candidate = BUILTIN_I8; break;
+		}
+		break;
+
+		case 3: switch(name[0])
+		{
+			case 'i': candidate = name[1] == '1' ? BUILTIN_I16 : name[1] == '3' ? BUILTIN_I32 : BUILTIN_I64; break;
+			case 'u': candidate = name[2] == '4' ? BUILTIN_UI4 : BUILTIN_UI8; break;
+			case 'f': candidate = BUILTIN_FLT; break;
+			case 'd': candidate = BUILTIN_DBL; break;
+			case 's': candidate = BUILTIN_SZE; break;
+			case 'b': candidate = BUILTIN_BLN; break;
+			case 'c': candidate = BUILTIN_CHR; break;
+			case 'n': candidate = BUILTIN_NLL; break;
+		}
+		break;
+
+		case 4: switch(name[0])
+		{
+			case 'i': candidate = BUILTIN_I128; break;
+			case 'u': candidate = name[2] == '1' ? BUILTIN_UI16 : name[2] == '3' ? BUILTIN_UI32 : BUILTIN_UI64; break;
+		}
+		break;
+
+		case 5: candidate = BUILTIN_UI128; break;
+	}
+	if(candidate == BUILTIN_NONE) return BUILTIN_NONE;
+
+	ccp expected = builtin_type_names[candidate];
+	for(size_t i = 0; i < length; i++) if(name[i] != expected[i]) return BUILTIN_NONE;
+	return expected[length] == '\0' ? candidate : BUILTIN_NONE;
+}
+
+// every compilation thread gets its own context and types
+extern thread_local llvm::LLVMContext __context;
+extern thread_local map<string, EviType*> __evi_types;
+extern thread_local EviType* __builtin_evi_types[BUILTIN_TYPE_COUNT];
+static thread_local bool __evi_builtin_types_initialized = false;
 
 // ================================
 
+// parsed types are interned per compilation: every distinct type exists once,
+// is never changed after creation and can be compared by its pointer. they and
+// the interner are allocated from the arena of the compilation
 class ParsedType
 {
 private:
-	EviType* _evi_type;
+	EviType* _evi_type = nullptr;
 	ParsedType* _subtype = nullptr;
+	// the same type without any modifiers, equal types share it
+	ParsedType* _unqualified = nullptr;
+	uint _depth = 0;
 
 	bool _invalid = false;
 
-public:
+	// generated on first use
+	llvm::Type* _llvm_type = nullptr;
+	string _string;
 
 	ParsedType() {};
-	ParsedType(LexicalType lexical_type, 
-			   EviType* evi_type = nullptr,
-			   bool is_reference = false,
-			   ParsedType* subtype = nullptr);
+	static void* operator new(size_t size) { return __arena->allocate(size, alignof(ParsedType)); }
+	static void operator delete(void* ptr) {}
+	static ParsedType* intern(LexicalType lexical_type, EviType* evi_type, ParsedType* subtype,
+							  bool is_constant, bool is_reference, bool keep_as_reference);
+
+public:
+	static ParsedType* get(LexicalType lexical_type, 
+						   EviType* evi_type = nullptr,
+						   bool is_reference = false,
+						   ParsedType* subtype = nullptr);
 	static ParsedType* new_invalid();
 
 	ParsedType* copy();
-	ParsedType* copy_change_lex(LexicalType type);
+	ParsedType* copy_change_constant(bool constant);
+	ParsedType* copy_as_reference();
+	ParsedType* copy_keep_as_reference();
 	ParsedType* copy_pointer_to();
 	ParsedType* copy_element_of();
-	void set_lex_type(LexicalType type);
 
 	string to_string(bool __first = true);
 	ccp to_c_string();
@@ -95,14 +186,17 @@ public:
 	bool _keep_as_reference = false;
 };
 
-#define PTYPE(...) (new ParsedType(__VA_ARGS__))
+#define PTYPE(...) (ParsedType::get(__VA_ARGS__))
 #define AS_LEX(ptype) (ptype->_lexical_type)
 
 // ================================
 
-#define ADD_EVI_TYPE(name, type) __evi_types.insert(pair<string, EviType*>(name, type))
+#define ADD_EVI_TYPE(name, type) \
+	(__evi_types.insert(pair<string, EviType*>(name, type)), \
+	 __builtin_evi_types[find_builtin_type(name, strlen(name))] = __evi_types.at(name))
 #define IS_EVI_TYPE(name) (__evi_types.find(name) != __evi_types.end())
 #define GET_EVI_TYPE(name) (_get_evi_type(name))
+#define GET_BUILTIN_EVI_TYPE(builtin) (__builtin_evi_types[builtin])
 
 static EviType* _get_evi_type(string name)
 {
@@ -116,12 +210,6 @@ static void init_builtin_evi_types()
 	if(__evi_builtin_types_initialized) return;
 	__evi_builtin_types_initialized = true;
 
-	lexical_type_strings[TYPE_INTEGER] = "integer";
-	lexical_type_strings[TYPE_FLOAT] = "float";
-	lexical_type_strings[TYPE_BOOL] = "boolean";
-	lexical_type_strings[TYPE_CHARACTER] = "character";
-	lexical_type_strings[TYPE_VOID] = "void";
-
 	// ======================= Integers =======================
 	ADD_EVI_TYPE("i1",  EVI_INT_TYPE("i1",  1,  true));
 
@@ -7,7 +7,7 @@
 
 using namespace std;
 
-class ASTVisualizer: public Visitor
+class ASTVisualizer: public Visitor<void>
 {
 	public:
 	void visualize(string path, AST* astree);
@@ -19,4 +19,12 @@
 	"-lm", \
 	"-o", outfile
 	
-#define LD_ARGC 18
\ No newline at end of file
+#define LD_ARGC 18
+
+// where the linker looks for -l libraries after the -L directories
+#define LD_DEFAULT_SEARCH_DIRS \
+	"/usr/local/lib", \
+	"/lib/x86_64-linux-gnu", \
+	"/usr/lib/x86_64-linux-gnu", \
+	"/lib", \
+	"/usr/lib"
@@ -0,0 +1,33 @@
+#include "arena.hpp"
+
+thread_local Arena* __arena = nullptr;
+
+Arena::~Arena()
+{
+	// destroy in reverse order of construction
+	for(auto it = _destructors.rbegin(); it != _destructors.rend(); it++) it->second(it->first);
+	for(char* block : _blocks) free(block);
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	#define ALIGN(ptr) ((char*)(((uintptr_t)(ptr) + alignment - 1) & ~(uintptr_t)(alignment - 1)))
+
+	char* start = ALIGN(_current);
+	if(!_current || start + size > _end)
+	{
+		// allocations bigger than a block get a block of their own
+		size_t block_size = max(size + alignment, (size_t)ARENA_BLOCK_SIZE);
+		char* block = (char*)malloc(block_size);
+		if(!block) THROW_INTERNAL_ERROR("in arena allocation");
+
+		_blocks.push_back(block);
+		_end = block + block_size;
+		start = ALIGN(block);
+	}
+
+	_current = start + size;
+	return start;
+
+	#undef ALIGN
+}
@@ -0,0 +1,167 @@
+#include "cache.hpp"
+#include "scanner.hpp"
+#include <llvm/Support/SHA1.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <unistd.h>
+#include <link.h>
+#include <atomic>
+#include <thread>
+
+cache_args_t cache_args = { false, false };
+
+static atomic<int> cache_hits(0);
+static atomic<int> cache_misses(0);
+
+// ================================
+
+// $EVI_CACHE_DIR, $XDG_CACHE_HOME/evi or ~/.cache/evi
+// (empty if the cache is disabled or has nowhere to go)
+static string get_cache_dir()
+{
+	if(cache_args.disabled) return "";
+
+	string dir;
+	if(getenv(CACHE_DIR_ENV)) dir = getenv(CACHE_DIR_ENV);
+	else if(getenv("XDG_CACHE_HOME")) dir = string(getenv("XDG_CACHE_HOME")) + "/" APP_NAME;
+	else if(getenv("HOME")) dir = string(getenv("HOME")) + "/.cache/" APP_NAME;
+	else return "";
+
+	if(llvm::sys::fs::create_directories(dir)) return "";
+	return dir;
+}
+
+static string get_entry_path(string key)
+{
+	string dir = get_cache_dir();
+	return dir.length() ? dir + "/" + key : "";
+}
+
+// ================================
+
+// stores the gnu build id of the executable (the first object) in data
+static int find_build_id(struct dl_phdr_info* info, size_t size, void* data)
+{
+	for(int i = 0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+		if(phdr.p_type != PT_NOTE) continue;
+
+		ccp note = (ccp)(info->dlpi_addr + phdr.p_vaddr);
+		ccp end = note + phdr.p_memsz;
+		while(note + sizeof(ElfW(Nhdr)) <= end)
+		{
+			const ElfW(Nhdr)* header = (const ElfW(Nhdr)*)note;
+			ccp name = note + sizeof(ElfW(Nhdr));
+			ccp desc = name + ((header->n_namesz + 3) & ~3);
+
+			if(header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 && !memcmp(name, "GNU", 4))
+			{
+				*(string*)data = llvm::toHex(llvm::StringRef(desc, header->n_descsz), true);
+				break;
+			}
+			note = desc + ((header->n_descsz + 3) & ~3);
+		}
+	}
+	return 1;
+}
+
+// identifies this exact build of evi: any rebuilt translation unit changes it.
+// that's the build id if it was linked with one, or else a hash of the binary
+static string get_compiler_id()
+{
+	static const string id = []() {
+		string build_id;
+		dl_iterate_phdr(find_build_id, &build_id);
+		if(build_id.length()) return build_id;
+
+		auto binary = llvm::MemoryBuffer::getFile("/proc/self/exe");
+		if(!binary) return string(APP_VERSION " " __DATE__ " " __TIME__);
+		return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef((*binary)->getBuffer())), true);
+	}();
+	return id;
+}
+
+string cache_key(ccp source, const SourceMap* map, string options)
+{
+	llvm::SHA1 hasher;
+
+	// entries made by a different build of the compiler are never valid
+	hasher.update(APP_VERSION " " + get_compiler_id() + "\n");
+	hasher.update(options + "\n");
+	hasher.update(source);
+
+	// file names and lines end up in diagnostics and debug info
+	for(const string& file : map->get_files()) hasher.update(file + "\n");
+	const vector<SourceRun>& runs = map->get_runs();
+	hasher.update(llvm::ArrayRef<uint8_t>((const uint8_t*)runs.data(), runs.size() * sizeof(SourceRun)));
+
+	return llvm::toHex(hasher.final(), true);
+}
+
+bool cache_lookup(string key, CacheEntry* entry)
+{
+	string path = get_entry_path(key);
+	ifstream file(path, ios::binary);
+
+	string magic;
+	size_t diagnostics_length;
+	if(!path.length() || !(file >> magic) || magic != CACHE_ENTRY_MAGIC
+	|| !(file >> entry->has_main >> diagnostics_length) || file.get() != '\n')
+	{
+		cache_misses++;
+		return false;
+	}
+
+	entry->diagnostics = string(diagnostics_length, '\0');
+	if(!file.read(&entry->diagnostics[0], diagnostics_length))
+	{
+		cache_misses++;
+		return false;
+	}
+
+	entry->data = string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	cache_hits++;
+	return true;
+}
+
+// entries are "<magic> <has_main> <diagnostics length>\n<diagnostics><data>"
+static void store_entry(string key, istream& artifact, bool has_main, string diagnostics)
+{
+	string path = get_entry_path(key);
+	if(!path.length() || !artifact) return;
+
+	// write to a temporary file first so that other
+	// evi processes never see a half-written entry
+	stringstream tmppath;
+	tmppath << path << ".tmp." << getpid() << "." << this_thread::get_id();
+
+	ofstream file(tmppath.str(), ios::binary);
+	file << CACHE_ENTRY_MAGIC " " << has_main << " " << diagnostics.length() << "\n" << diagnostics;
+	file << artifact.rdbuf();
+	file.close();
+
+	if(!file || rename(tmppath.str().c_str(), path.c_str()))
+		remove(tmppath.str().c_str());
+}
+
+void cache_store(string key, ccp artifact, bool has_main, string diagnostics)
+{
+	ifstream file(artifact, ios::binary);
+	store_entry(key, file, has_main, diagnostics);
+}
+
+void cache_store_data(string key, string data, bool has_main, string diagnostics)
+{
+	stringstream stream(data);
+	store_entry(key, stream, has_main, diagnostics);
+}
+
+void cache_report()
+{
+	if(!cache_args.print_stats) return;
+
+	string dir = get_cache_dir();
+	cerr << tools::fstr("[evi] Cache: %d hit(s), %d miss(es) (%s).", cache_hits.load(),
+						cache_misses.load(), dir.length() ? dir.c_str() : "disabled") << endl;
+}
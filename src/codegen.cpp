@@ -1,28 +1,66 @@
 #include "codegen.hpp"
+#include "timing.hpp"
 #include <unistd.h>
+#include <sys/mman.h>
+#include <mutex>
+#include <set>
 
-CodeGenerator::CodeGenerator()
+static once_flag targets_initialized;
+static mutex lld_mutex; // lld is not reentrant
+pgo_args_t pgo_args = { false, nullptr, nullptr };
+
+CodeGenerator::CodeGenerator(string cpu, string features, int codegen_threads)
 {
 	_errstream = new llvm::raw_os_ostream(cerr);
 
-	// target machine stuff
-	llvm::InitializeAllTargetInfos();
-	llvm::InitializeAllTargets();
-	llvm::InitializeAllTargetMCs();
-	llvm::InitializeAllAsmParsers();
-	llvm::InitializeAllAsmPrinters();
+	// target machine stuff (only once, codegens may run on multiple threads)
+	call_once(targets_initialized, []{
+		llvm::InitializeAllTargetInfos();
+		llvm::InitializeAllTargets();
+		llvm::InitializeAllTargetMCs();
+		llvm::InitializeAllAsmParsers();
+		llvm::InitializeAllAsmPrinters();
+	});
 
 	_target_triple = llvm::sys::getDefaultTargetTriple();
-	string cpu = "generic";
-	string features = "";
+	resolve_target(&cpu, &features);
+	_target_cpu = cpu;
+	_target_features = features;
+	_codegen_threads = codegen_threads;
+	_target_machine = create_target_machine();
+
+	if(!_target_machine->getMCSubtargetInfo()->isCPUStringValid(cpu))
+	{
+		_error_dispatcher.error("CLI Error", tools::fstr("Unknown target cpu \"%s\".", cpu.c_str()).c_str());
+		ABORT(STATUS_CLI_ERROR);
+	}
+}
 
+llvm::TargetMachine* CodeGenerator::create_target_machine()
+{
 	string error;
 	const llvm::Target* target = llvm::TargetRegistry::lookupTarget(_target_triple, error);
 	if (!target) { cerr << error; ABORT(STATUS_CODEGEN_ERROR); }
 
 	llvm::TargetOptions opt;
 	auto rm = llvm::Optional<llvm::Reloc::Model>();
-	_target_machine = target->createTargetMachine(_target_triple, cpu, features, opt, rm);
+	return target->createTargetMachine(_target_triple, _target_cpu, _target_features, opt, rm);
+}
+
+void CodeGenerator::resolve_target(string* cpu, string* features)
+{
+	// 'native' cpu implies native features unless they're given
+	bool native_features = *features == "native" || (*cpu == "native" && features->empty());
+	if(*cpu == "native") *cpu = llvm::sys::getHostCPUName().str();
+
+	if(native_features)
+	{
+		llvm::SubtargetFeatures subtarget_features;
+		llvm::StringMap<bool> host_features;
+		if(llvm::sys::getHostCPUFeatures(host_features))
+			for(auto& feature : host_features) subtarget_features.AddFeature(feature.first(), feature.second);
+		*features = subtarget_features.getString();
+	}
 }
 
 Status CodeGenerator::emit_llvm(ccp outfile)
@@ -36,6 +74,15 @@ Status CodeGenerator::emit_llvm(ccp outfile)
 
 Status CodeGenerator::emit_object(ccp outfile)
 {
+	// partitions are emitted in memory and put back together
+	if(_codegen_threads > 1)
+	{
+		vector<string> partitions;
+		Status status = emit_object_in_memory(&partitions);
+		if(status != STATUS_SUCCESS) return status;
+		return link_partitions(outfile, &partitions);
+	}
+
 	error_code errcode;
 	llvm::raw_fd_ostream dest(outfile, errcode, llvm::sys::fs::OF_None);
 
@@ -46,6 +93,84 @@ Status CodeGenerator::emit_object(ccp outfile)
 		ABORT(STATUS_CODEGEN_ERROR);
 	}
 
+	if(!add_emit_passes_and_run(dest)) { remove(outfile); ABORT(STATUS_CODEGEN_ERROR); }
+	dest.flush();
+	return STATUS_SUCCESS;
+}
+
+Status CodeGenerator::emit_object_in_memory(vector<string>* paths)
+{
+	vector<llvm::SmallVector<char, 0>> buffers(max(_codegen_threads, 1));
+	if(buffers.size() > 1) emit_partitions(&buffers);
+	else
+	{
+		llvm::raw_svector_ostream dest(buffers[0]);
+		if(!add_emit_passes_and_run(dest)) ABORT(STATUS_CODEGEN_ERROR);
+	}
+
+	for(llvm::SmallVector<char, 0>& buffer : buffers)
+	{
+		string path;
+		Status status = write_memory_object(_infile, llvm::StringRef(buffer.data(), buffer.size()), &path);
+		if(status != STATUS_SUCCESS) return status;
+		paths->push_back(path);
+	}
+	return STATUS_SUCCESS;
+}
+
+void CodeGenerator::emit_partitions(vector<llvm::SmallVector<char, 0>>* buffers)
+{
+	vector<unique_ptr<llvm::raw_svector_ostream>> streams;
+	vector<llvm::raw_pwrite_stream*> dests;
+	for(llvm::SmallVector<char, 0>& buffer : *buffers)
+	{
+		streams.push_back(make_unique<llvm::raw_svector_ostream>(buffer));
+		dests.push_back(streams.back().get());
+	}
+
+	// splits the module with llvm::SplitModule and emits every partition on a
+	// thread pool, each in its own context (through bitcode) with its own target machine.
+	// locals (string literals, static functions, the internalized stdlib) stay local:
+	// otherwise they're made hidden globals and every file defines its own '.str.0'
+	DEBUG_PRINT_F_MSG("Emitting %d partitions...", (int)buffers->size());
+	llvm::splitCodeGen(move(_top_module), dests, {}, [&]() {
+		return unique_ptr<llvm::TargetMachine>(create_target_machine());
+	}, llvm::CGFT_ObjectFile, /*PreserveLocals=*/true);
+}
+
+Status CodeGenerator::link_partitions(ccp outfile, vector<string>* partitions)
+{
+	vector<ccp> args = { "ld.lld", "-r", "-o", outfile };
+	for(string& partition : *partitions) args.push_back(partition.c_str());
+
+	lock_guard<mutex> lock(lld_mutex);
+	if(!lld::elf::link(args, false, llvm::outs(), llvm::errs()))
+	{
+		_error_dispatcher.error("Code Generation Error", tools::fstr(
+			"Could not link the code generation partitions into \"%s\".", outfile).c_str());
+		return STATUS_CODEGEN_ERROR;
+	}
+	return STATUS_SUCCESS;
+}
+
+Status CodeGenerator::write_memory_object(ccp name, llvm::StringRef object, string* path)
+{
+	// the object lives in an anonymous file in memory that
+	// stays open (and thus linkable) until the process exits
+	int fd = memfd_create(name, 0);
+	if(fd < 0 || write(fd, object.data(), object.size()) != (ssize_t)object.size())
+	{
+		ErrorDispatcher().error("Code Generation Error",
+			tools::fstr("Could not create in-memory object file: %s.", strerror(errno)).c_str());
+		return STATUS_CODEGEN_ERROR;
+	}
+
+	*path = tools::fstr(MEMORY_OBJ_FILE_TEMPLATE, fd);
+	return STATUS_SUCCESS;
+}
+
+bool CodeGenerator::add_emit_passes_and_run(llvm::raw_pwrite_stream& dest)
+{
 	llvm::legacy::PassManager pass;
 	auto filetype = llvm::CGFT_ObjectFile;
 
@@ -53,49 +178,185 @@ Status CodeGenerator::emit_object(ccp outfile)
 	{
 		_error_dispatcher.error("Code Generation Error",
 			"Target machine incompatible with object file type.");
-		remove(outfile);
-		ABORT(STATUS_CODEGEN_ERROR);
+		return false;
 	}
 
 	pass.run(*_top_module);
-	dest.flush();
-	return STATUS_SUCCESS;
+	return true;
 }
 
-Status CodeGenerator::emit_binary(ccp outfile, ccp* linked, int linkedc)
+Status CodeGenerator::emit_binary(ccp outfile, ccp* objects, int objectsc, ccp* linked, int linkedc, bool external_ld)
 {
-	// write to temporary object file
-	ccp objfile = strdup(tools::fstr(TEMP_OBJ_FILE_TEMPLATE, _infile, time(0)).c_str());
-	DEBUG_PRINT_F_MSG("Emitting object file... (%s)", objfile);
-	Status objstatus = emit_object(objfile);
-	if(objstatus != STATUS_SUCCESS) return objstatus; 
-
-	// object file written, now invoke llc
-	// int ldstatus = execl(LD_PATH, CC_ARGS, NULL);
-	string ldcommand; ccp infile = objfile;
-	for(int i = 0; i < LD_ARGC; i++) { ldcommand += (ccp[]){LD_ARGS}[i]; ldcommand += " "; }
-	for(int i = 0; i < linkedc; i++) ldcommand += string(linked[i]) + " ";
+	ErrorDispatcher error_dispatcher = ErrorDispatcher();
+
+	// LD_ARGS expects a single input file. all object files go in
+	// its place so that they're linked before the static libraries
+	ccp infile = "<object-files>";
+	vector<ccp> args;
+	for(ccp arg : (ccp[]){LD_ARGS})
+	{
+		if(arg == infile) args.insert(args.end(), objects, objects + objectsc);
+		else args.push_back(arg);
+	}
+	args.insert(args.end(), linked, linked + linkedc);
+
+	// instrumented programs need the profile runtime. the driver is expected to
+	// pull in the member that registers the profile writer, so we have to too
+	if(pgo_args.generate) args.insert(args.end(), {"-u", "__llvm_profile_runtime", PROFILE_RT_LIB});
+
+	if(!external_ld)
+	{
+		DEBUG_PRINT_MSG("Linking with embedded lld (with stdlib at " STATICLIB_DIR ")");
+
+		lock_guard<mutex> lock(lld_mutex);
+
+		if(!lld::elf::link(args, false, llvm::outs(), llvm::errs()))
+		{
+			error_dispatcher.error("Linking Error", "Linking with embedded lld failed.");
+			return STATUS_OUTPUT_ERROR;
+		}
+		return STATUS_SUCCESS;
+	}
+
+	// object files written, now invoke ld
+	string ldcommand;
+	for(ccp arg : args) { ldcommand += arg; ldcommand += " "; }
 
 	DEBUG_PRINT_MSG("Invoking linker (" LD_PATH " with stdlib at " STATICLIB_DIR ")");
 	DEBUG_PRINT_F_MSG("Linker command: %s", ldcommand.c_str());
 
 	int ldstatus = system(ldcommand.c_str());
+
+	// clean up
+	for(int i = 0; i < objectsc; i++)
+	{
+		DEBUG_PRINT_F_MSG("Cleaning up object file... (%s)", objects[i]);
+		remove(objects[i]);
+	}
+
 	if(ldstatus)
 	{
-		_error_dispatcher.error("Linking Error", tools::fstr(
+		error_dispatcher.error("Linking Error", tools::fstr(
 			"Linking with " LD_PATH " failed with code %d.", ldstatus).c_str());
-		remove(objfile);
 		return STATUS_OUTPUT_ERROR;
 	}
+	return STATUS_SUCCESS;
+}
 
-	// clean up
-	DEBUG_PRINT_F_MSG("Cleaning up object file... (%s)", objfile);
-	remove(objfile);
-	free((void*)objfile);
+Status CodeGenerator::emit_bitcode_in_memory(string* bitcode)
+{
+	llvm::raw_string_ostream dest(*bitcode);
+	llvm::WriteBitcodeToFile(*_top_module, dest);
+	dest.flush();
+	return STATUS_SUCCESS;
+}
+
+Status CodeGenerator::resolve_jit_libraries(ccp* linked, int linkedc, vector<string>* libraries)
+{
+	// the directories the linker would search (see emit_binary)
+	ccp infile = "", outfile = "";
+	vector<string> dirs;
+	for(int i = 0; i < linkedc; i++) if(!strncmp(linked[i], "-L", 2)) dirs.push_back(linked[i] + 2);
+	for(ccp arg : (ccp[]){LD_ARGS}) if(!strncmp(arg, "-L", 2)) dirs.push_back(arg + 2);
+	dirs.insert(dirs.end(), {LD_DEFAULT_SEARCH_DIRS});
+
+	for(int i = 0; i < linkedc; i++)
+	{
+		if(!strncmp(linked[i], "-L", 2)) continue;
+		else if(linked[i][0] != '-') { libraries->push_back(linked[i]); continue; }
+		else if(linked[i][1] != 'l')
+		{
+			ErrorDispatcher().error("JIT Error", tools::fstr(
+				"Linker option \"%s\" is not supported when running.", linked[i]).c_str());
+			return STATUS_CODEGEN_ERROR;
+		}
+
+		// -lfoo is libfoo.so, or libfoo.a if there's no shared library
+		string library;
+		for(string& dir : dirs) for(ccp extension : {".so", ".a"})
+		{
+			string path = dir + "/lib" + (linked[i] + 2) + extension;
+			if(library.empty() && llvm::sys::fs::exists(path)) library = path;
+		}
+
+		if(library.empty())
+		{
+			ErrorDispatcher().error("JIT Error", tools::fstr(
+				"Could not find library \"%s\".", linked[i] + 2).c_str());
+			return STATUS_CODEGEN_ERROR;
+		}
+		libraries->push_back(library);
+	}
 	return STATUS_SUCCESS;
 }
 
-Status CodeGenerator::generate(ccp infile, ccp outfile, ccp source, AST* astree, OptimizationType opt, bool debug_info)
+Status CodeGenerator::run_jit(vector<string>* bitcodes, ccp* linked, int linkedc, vector<string> args, int* exitcode)
+{
+	ErrorDispatcher error_dispatcher = ErrorDispatcher();
+
+	#define RETURN_IF_ERROR(expr) if(llvm::Error error = (expr)) { error_dispatcher.error("JIT Error", \
+									llvm::toString(move(error)).c_str()); return STATUS_CODEGEN_ERROR; }
+
+	// function bodies are only compiled once they're first called
+	auto jit = llvm::orc::LLLazyJITBuilder().create();
+	RETURN_IF_ERROR(jit.takeError());
+	llvm::orc::JITDylib& dylib = (*jit)->getMainJITDylib();
+	char prefix = (*jit)->getDataLayout().getGlobalPrefix();
+
+	// libc and friends are resolved from the evi process itself
+	auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix);
+	RETURN_IF_ERROR(process.takeError());
+	dylib.addGenerator(move(*process));
+
+	// the evi static library and linked archives are loaded into the jit
+	// (the same as the linker would), other linked files are opened as shared libraries
+	vector<string> libraries = { string(STATICLIB_DIR) + "/libevi.a" };
+	Status status = resolve_jit_libraries(linked, linkedc, &libraries);
+	if(status != STATUS_SUCCESS) return status;
+	for(string& library : libraries)
+	{
+		DEBUG_PRINT_F_MSG("Loading library into JIT... (%s)", library.c_str());
+
+		if(llvm::StringRef(library).endswith(".a"))
+		{
+			auto generator = llvm::orc::StaticLibraryDefinitionGenerator::Load(
+				(*jit)->getObjLinkingLayer(), library.c_str());
+			RETURN_IF_ERROR(generator.takeError());
+			dylib.addGenerator(move(*generator));
+		}
+		else
+		{
+			auto generator = llvm::orc::DynamicLibrarySearchGenerator::Load(library.c_str(), prefix);
+			RETURN_IF_ERROR(generator.takeError());
+			dylib.addGenerator(move(*generator));
+		}
+	}
+
+	// the modules were generated in thread-local contexts
+	// that are gone by now, so each gets its own new context
+	for(string& bitcode : *bitcodes)
+	{
+		auto context = make_unique<llvm::LLVMContext>();
+		auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, args[0]), *context);
+		RETURN_IF_ERROR(module.takeError());
+		RETURN_IF_ERROR((*jit)->addLazyIRModule(llvm::orc::ThreadSafeModule(move(*module), move(context))));
+	}
+
+	RETURN_IF_ERROR((*jit)->initialize(dylib));
+
+	auto mainsym = (*jit)->lookup("main");
+	RETURN_IF_ERROR(mainsym.takeError());
+
+	DEBUG_PRINT_MSG("Running main in JIT");
+	auto mainfunc = (int(*)(int, char**))mainsym->getAddress();
+	*exitcode = llvm::orc::runAsMain(mainfunc, llvm::ArrayRef<string>(args).drop_front(), llvm::StringRef(args[0]));
+
+	RETURN_IF_ERROR((*jit)->deinitialize(dylib));
+	#undef RETURN_IF_ERROR
+	return STATUS_SUCCESS;
+}
+
+Status CodeGenerator::generate(ccp infile, ccp outfile, ccp source, AST* astree, OptimizationType opt, bool debug_info, LTOType lto)
 {
 	_outfile = strdup(outfile);
 	_infile = strdup(infile);
@@ -103,19 +364,23 @@ Status CodeGenerator::generate(ccp infile, ccp outfile, ccp source, AST* astree,
 
 	_build_debug_info = debug_info;
 	_opt_level = opt;
+	_lto = lto;
 
+	PhaseTimer codegen_timer("codegen", infile);
 	prepare();
 
 	// walk the tree
-	for(auto& node : *astree) if(node)
-	{
-		node->accept(this);
-		pop();
-	}
+	for(auto& node : *astree) if(node) node->accept(this);
+	codegen_timer.count(_top_module->getInstructionCount(), "instructions");
+	codegen_timer.stop();
 
+	PhaseTimer optimize_timer("optimize", infile);
 	optimize();
+	optimize_timer.stop();
 
+	PhaseTimer verify_timer("verify", infile);
 	finish();
+	verify_timer.stop();
 
 	// done!
 	DEBUG_PRINT_MSG("Codegen done!");
@@ -136,7 +401,8 @@ void CodeGenerator::prepare()
 	_top_module->setDataLayout(_target_machine->createDataLayout());
 	_top_module->setTargetTriple(_target_triple);
 
-	_value_stack = new stack<llvm::Value*>();
+	_global_slots.clear();
+	_local_slots.clear();
 	_string_literal_count = 0;
 
 	if(_build_debug_info) _debug_info_builder = new DebugInfoBuilder(
@@ -144,10 +410,75 @@ void CodeGenerator::prepare()
 }
 
 void CodeGenerator::optimize()
+{
+	if(_lto == LTO_NONE) { run_pass_pipeline(PIPELINE_PER_MODULE); return; }
+
+	// the same as clang -flto: the pre-link pipeline for the module itself, then the
+	// lto pipeline over the module together with the (already optimized) stdlib bitcode
+	run_pass_pipeline(PIPELINE_LTO_PRE_LINK);
+	link_stdlib();
+	run_pass_pipeline(PIPELINE_LTO);
+}
+
+void CodeGenerator::link_stdlib()
+{
+	string path = string(STATICLIB_DIR) + "/" STDLIB_BITCODE_FILE;
+	DEBUG_PRINT_F_MSG("Linking stdlib bitcode... (%s)", path.c_str());
+
+	auto buffer = llvm::MemoryBuffer::getFile(path);
+	if(!buffer)
+	{
+		_error_dispatcher.error("Code Generation Error", tools::fstr("Could not open stdlib bitcode \"%s\": %s.",
+								path.c_str(), buffer.getError().message().c_str()).c_str());
+		ABORT(STATUS_CODEGEN_ERROR);
+	}
+
+	auto stdlib = llvm::parseBitcodeFile(**buffer, __context);
+	if(!stdlib)
+	{
+		_error_dispatcher.error("Code Generation Error", tools::fstr("Could not read stdlib bitcode \"%s\": %s.",
+								path.c_str(), llvm::toString(stdlib.takeError()).c_str()).c_str());
+		ABORT(STATUS_CODEGEN_ERROR);
+	}
+
+	// unless this module is the whole program its own definitions
+	// might be used by other files, so only main and those stay visible
+	set<string> preserved = { "main" };
+	if(_lto != LTO_WHOLE_PROGRAM) for(llvm::GlobalValue& value : _top_module->global_values())
+		if(!value.isDeclaration() && !value.hasLocalLinkage()) preserved.insert(value.getName().str());
+
+	if(llvm::Linker::linkModules(*_top_module, move(*stdlib), llvm::Linker::LinkOnlyNeeded))
+	{
+		_error_dispatcher.error("Code Generation Error", tools::fstr(
+			"Could not link stdlib bitcode \"%s\".", path.c_str()).c_str());
+		ABORT(STATUS_CODEGEN_ERROR);
+	}
+
+	llvm::internalizeModule(*_top_module, [&](const llvm::GlobalValue& value) {
+		return preserved.count(value.getName().str()) > 0;
+	});
+}
+
+void CodeGenerator::run_pass_pipeline(PipelineType pipeline)
 {
 	if(_opt_level == OPTIMIZE_On) return;
 
-	llvm::PassBuilder pass_builder;
+	// the target machine tells the vectorizers what the target cpu can do.
+	// llvm passes show up in the time trace as well
+	llvm::PassInstrumentationCallbacks pass_callbacks;
+	timing_register_pass_callbacks(&pass_callbacks);
+
+	// profile guided optimization (instrumenting or using a profile)
+	llvm::Optional<llvm::PGOOptions> pgo_options;
+	if(pgo_args.generate) pgo_options = llvm::PGOOptions(pgo_args.generate_file ? pgo_args.generate_file : "",
+														 "", "", llvm::PGOOptions::IRInstr);
+	else if(pgo_args.use_file) pgo_options = llvm::PGOOptions(pgo_args.use_file, "", "", llvm::PGOOptions::IRUse);
+
+	#ifdef DEBUG
+	llvm::PassBuilder pass_builder(true, _target_machine, llvm::PipelineTuningOptions(), pgo_options, &pass_callbacks);
+	#else
+	llvm::PassBuilder pass_builder(false, _target_machine, llvm::PipelineTuningOptions(), pgo_options, &pass_callbacks);
+	#endif
 
 	// create analysis managers
 	#ifdef DEBUG
@@ -186,7 +517,13 @@ void CodeGenerator::optimize()
 	}
 
 	// run the optimization
-	llvm::ModulePassManager module_pass_manager = pass_builder.buildPerModuleDefaultPipeline(level);
+	llvm::ModulePassManager module_pass_manager;
+	switch(pipeline)
+	{
+		case PIPELINE_PER_MODULE: module_pass_manager = pass_builder.buildPerModuleDefaultPipeline(level); break;
+		case PIPELINE_LTO_PRE_LINK: module_pass_manager = pass_builder.buildLTOPreLinkDefaultPipeline(level); break;
+		case PIPELINE_LTO: module_pass_manager = pass_builder.buildLTODefaultPipeline(level, nullptr); break;
+	}
 	module_pass_manager.run(*_top_module, module_analysis_manager);
 }
 
@@ -225,37 +562,38 @@ void CodeGenerator::finish()
 
 // =========================================
 
-void CodeGenerator::error_at(Token *token, string message)
+void CodeGenerator::error_at(Token token, string message)
 {
-	_error_dispatcher.error_at_token(token, "Code Generation Error", message.c_str());
+	_error_dispatcher.error_at_token(&token, "Code Generation Error", message.c_str());
 
 	// print token
 	cerr << endl;
-	_error_dispatcher.print_token_marked(token, COLOR_RED);
+	_error_dispatcher.print_token_marked(&token, COLOR_RED);
 	
 	ABORT(STATUS_CODEGEN_ERROR);
 }
 
-void CodeGenerator::warning_at(Token *token, string message)
+void CodeGenerator::warning_at(Token token, string message)
 {
 	// just a lil warnign
-	_error_dispatcher.warning_at_token(token, "Code Generation Warning", message.c_str());
+	_error_dispatcher.warning_at_token(&token, "Code Generation Warning", message.c_str());
 }
 
 // =========================================
 
-void CodeGenerator::push(llvm::Value* value)
+pair<llvm::Value*, ParsedType*>& CodeGenerator::get_slot(Slot slot)
 {
-	//
-	_value_stack->push(value);
-}
+	ASSERT_OR_THROW_INTERNAL_ERROR(slot.index >= 0, "during slot retrieval");
 
-llvm::Value* CodeGenerator::pop()
-{
-	ASSERT_OR_THROW_INTERNAL_ERROR(!_value_stack->empty(), "during code generation");
-	llvm::Value* value = _value_stack->top();
-	_value_stack->pop();
-	return value;
+	// globals are bound as their declarations come by
+	if(slot.global)
+	{
+		if(slot.index >= _global_slots.size()) _global_slots.resize(slot.index + 1, {nullptr, nullptr});
+		return _global_slots[slot.index];
+	}
+
+	ASSERT_OR_THROW_INTERNAL_ERROR(slot.index < _local_slots.size(), "during slot retrieval");
+	return _local_slots[slot.index];
 }
 
 // =========================================
@@ -310,18 +648,18 @@ ParsedType* CodeGenerator::from_token_type(TokenType type)
 
 // =========================================
 
-#define VISIT(_node) void CodeGenerator::visit(_node* node)
-#define DEBUG_EMITLOC() if(_build_debug_info) _debug_info_builder->emit_location(node->_token.line, get_token_col(&node->_token))
+#define VISIT(_node) llvm::Value* CodeGenerator::visit(_node* node)
+#define DEBUG_EMITLOC() if(_build_debug_info) \
+	{ Token __token = node->token(); _debug_info_builder->emit_location(__token.line, get_token_col(&__token)); }
 #define IF_BUILD_DEBUG if(_build_debug_info)
-#define ACCEPT_AND_POP(node) { if(node) { node->accept(this); pop(); } }
+#define ACCEPT_IF_SET(node) { if(node) node->accept(this); }
 #define ERROR_AT(token, format, ...) error_at(token, tools::fstr(format, __VA_ARGS__))
-#define SCOPE_UP() map<string, pair<llvm::Value*, ParsedType*>> oldbindings = _named_values
-#define SCOPE_DOWN() _named_values = oldbindings
 
 // === Statements ===
 
 VISIT(FuncDeclNode)
 {
+	TIME_TRACE_SCOPE("codegen function", node->_identifier);
 	DEBUG_EMITLOC();
 
 	llvm::Function* func;
@@ -334,6 +672,10 @@ VISIT(FuncDeclNode)
 		llvm::FunctionType* functype = llvm::FunctionType::get(node->_ret_type->get_llvm_type(), params, node->_variadic);
 		func = llvm::Function::Create(functype, node->_static ? llvm::Function::InternalLinkage : llvm::Function::ExternalLinkage,
 									  node->_identifier, *_top_module);
+
+		// lets the vectorizers and such use everything the target has
+		func->addFnAttr("target-cpu", _target_cpu);
+		if(!_target_features.empty()) func->addFnAttr("target-features", _target_features);
 		
 		_functions[node->_identifier] = func;
 	}
@@ -346,7 +688,7 @@ VISIT(FuncDeclNode)
 
 		IF_BUILD_DEBUG
 		{
-			llvm::DIFile* unit = _debug_info_builder->create_file_unit(*node->_token.file);
+			llvm::DIFile* unit = _debug_info_builder->create_file_unit(*node->token().file);
 			llvm::DISubprogram* subprog = _debug_info_builder->create_subprogram(node, unit);
 
 			func->setSubprogram(subprog);
@@ -354,7 +696,8 @@ VISIT(FuncDeclNode)
 			// _debug_info_builder->emit_location(0, 0);
 		}
 
-		SCOPE_UP();
+		// the parameters take the first slots
+		_local_slots.assign(node->_slot_count, {nullptr, nullptr});
 
 		// alloc each parameter
 		for (int i = 0; i < params.size(); i++) {
@@ -367,21 +710,19 @@ VISIT(FuncDeclNode)
 			_builder->CreateStore(arg, alloca);
 
 			// Add arguments to variable symbol table.
-			_named_values[to_string(i)].first = alloca;
-			_named_values[to_string(i)].second = node->_params[i];
+			_local_slots[i] = {alloca, node->_params[i]};
 
 			// add debugging info to parameter
 			if(_build_debug_info)
 			{
 				llvm::DILocalVariable* d = _debug_info_builder->create_parameter(
-					i, node->_token.line, node->_params[i]);
+					i, node->token().line, node->_params[i]);
 				_debug_info_builder->insert_declare(alloca, d);
 			}
 		}
 
 		// eval the body
 		node->_body->accept(this);
-		SCOPE_DOWN();
 
 		// finish off function
 		if(func->getBasicBlockList().back().getInstList().back().isTerminator()) {}
@@ -395,7 +736,7 @@ VISIT(FuncDeclNode)
 		IF_BUILD_DEBUG _debug_info_builder->pop_subprogram();
 	}
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(VarDeclNode)
@@ -424,8 +765,7 @@ VISIT(VarDeclNode)
 		// set initializer?
 		if(node->_expr)
 		{
-			node->_expr->accept(this);
-			llvm::Value* val = create_cast(pop(), false, node->_type->get_llvm_type(), node->_type->is_signed());
+			llvm::Value* val = create_cast(node->_expr->accept(this), false, node->_type->get_llvm_type(), node->_type->is_signed());
 			global_var->setInitializer((llvm::Constant*)val);
 		}
 		else
@@ -434,19 +774,14 @@ VISIT(VarDeclNode)
 			global_var->setInitializer(init);
 		}
 		
-		_named_values[node->_identifier].first = global_var;
-		_named_values[node->_identifier].second = node->_type;
+		get_slot(node->_slot) = {global_var, node->_type};
 		storage = global_var;
 	}
 	else // local
 	{
 		// set initializer?
 		llvm::Value* init;
-		if(node->_expr)
-		{
-			node->_expr->accept(this);
-			init = pop();
-		}
+		if(node->_expr) init = node->_expr->accept(this);
 		else init = llvm::Constant::getNullValue(node->_type->get_llvm_type());
 	
 		init = create_cast(init, true, node->_type->get_llvm_type(), node->_type->is_signed());
@@ -454,8 +789,7 @@ VISIT(VarDeclNode)
 		llvm::AllocaInst* alloca = create_entry_block_alloca(node->_type->get_llvm_type(), ir_name);
 		_builder->CreateStore(init, alloca);
 	
-		_named_values[node->_identifier].first = alloca;
-		_named_values[node->_identifier].second = node->_type;
+		get_slot(node->_slot) = {alloca, node->_type};
 		storage = alloca;
 	}
 
@@ -464,31 +798,29 @@ VISIT(VarDeclNode)
 		ASSERT_OR_THROW_INTERNAL_ERROR(storage, "during debug info generation");
 
 		llvm::DILocalVariable* v = _debug_info_builder->create_variable(
-			node->_identifier, node->_token.line, node->_type, node->_is_global);
+			node->_identifier, node->token().line, node->_type, node->_is_global);
 		_debug_info_builder->insert_declare(storage, v);
 	}
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(AssignNode)
 {
 	DEBUG_EMITLOC();
-	llvm::Value* target = _named_values[node->_ident].first;
-	ParsedType* type = _named_values[node->_ident].second;
+	llvm::Value* target = get_slot(node->_slot).first;
+	ParsedType* type = get_slot(node->_slot).second;
 
 	// handle subscripts
 	for(auto& subnode : node->_subscripts)
 	{
-		subnode->accept(this);
-		llvm::Value* index = pop();
+		llvm::Value* index = subnode->accept(this);
 
 		target = _builder->CreateInBoundsGEP(_builder->CreateLoad(target, "asslodtmp"), index, "assgeptmp");
 		type = type->copy_element_of();
 	}
 
-	node->_expr->accept(this);
-	llvm::Value* rawval = pop();
+	llvm::Value* rawval = node->_expr->accept(this);
 
 	llvm::Instruction::CastOps cop = llvm::CastInst::getCastOpcode(
 		rawval, true, type->get_llvm_type(), type->is_signed());
@@ -496,16 +828,14 @@ VISIT(AssignNode)
 	
 	_builder->CreateStore(val, target);
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(IfNode)
 {
 	DEBUG_EMITLOC();
-	node->_cond->accept(this);
-	
 	// create comparison
-	llvm::Value* cond = to_bool(pop());
+	llvm::Value* cond = to_bool(node->_cond->accept(this));
 
 	llvm::Function* func = _builder->GetInsertBlock()->getParent();
 
@@ -516,13 +846,13 @@ VISIT(IfNode)
 
 	// Emit then block
 	_builder->SetInsertPoint(thenblock);
-	ACCEPT_AND_POP(node->_then);
+	ACCEPT_IF_SET(node->_then);
 	_builder->CreateBr(endblock);
 	thenblock = _builder->GetInsertBlock(); // update thenblock since it changes
 
 	// Emit else block
 	_builder->SetInsertPoint(elseblock);
-	ACCEPT_AND_POP(node->_else);
+	ACCEPT_IF_SET(node->_else);
 	_builder->CreateBr(endblock);
 	elseblock = _builder->GetInsertBlock(); // update elseblock since it changes
 
@@ -530,7 +860,7 @@ VISIT(IfNode)
 	func->getBasicBlockList().push_back(endblock);
 	_builder->SetInsertPoint(endblock);
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(LoopNode)
@@ -541,58 +871,45 @@ VISIT(LoopNode)
 	llvm::BasicBlock* loopblock = llvm::BasicBlock::Create(__context, "loopbody", func);
 	llvm::BasicBlock* endblock = llvm::BasicBlock::Create(__context, "loopcont", func);
 
-	SCOPE_UP();
-
 	// first do initializer
-	ACCEPT_AND_POP(node->_init);
+	ACCEPT_IF_SET(node->_init);
 	_builder->CreateBr(condblock);
 
 	// then do condition
 	_builder->SetInsertPoint(condblock);
-	node->_cond->accept(this);
-	_builder->CreateCondBr(to_bool(pop()), loopblock, endblock);
+	_builder->CreateCondBr(to_bool(node->_cond->accept(this)), loopblock, endblock);
 	condblock = _builder->GetInsertBlock(); // update condblock
 
 	// finally do loop body and incrementor
 	_builder->SetInsertPoint(loopblock);
-	ACCEPT_AND_POP(node->_body);
-	ACCEPT_AND_POP(node->_incr);
+	ACCEPT_IF_SET(node->_body);
+	ACCEPT_IF_SET(node->_incr);
 	_builder->CreateBr(condblock);
 	loopblock = _builder->GetInsertBlock(); // update loopblock
 
 	// patch up
 	_builder->SetInsertPoint(endblock);
 	endblock->moveAfter(loopblock);
-	SCOPE_DOWN();
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(ReturnNode)
 {
 	DEBUG_EMITLOC();
-	if(node->_expr)
-	{
-		node->_expr->accept(this);
-		_builder->CreateRet(create_cast(pop(), false, node->_expected_type->get_llvm_type(), false));
-	}
+	if(node->_expr) _builder->CreateRet(create_cast(node->_expr->accept(this), false, node->_expected_type->get_llvm_type(), false));
 	else _builder->CreateRetVoid();
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(BlockNode)
 {
 	DEBUG_EMITLOC();
-	if(!node->_secret)
-	{
-		SCOPE_UP();
-		for(StmtNode*& stmt : node->_statements) ACCEPT_AND_POP(stmt);
-		SCOPE_DOWN();
-	}
-	else for(StmtNode*& stmt : node->_statements) ACCEPT_AND_POP(stmt);
+	// variables are bound to their own slots, so scopes need no bookkeeping
+	for(StmtNode*& stmt : node->_statements) ACCEPT_IF_SET(stmt);
 
-	push(nullptr);
+	return nullptr;
 }
 
 // === Expressions ===
@@ -602,31 +919,30 @@ VISIT(LogicalNode)
 	DEBUG_EMITLOC();
 	llvm::Function* func = _builder->GetInsertBlock()->getParent();
 
-	if(node->_token.type == TOKEN_QUESTION) // ternary
+	if(node->_optype == TOKEN_QUESTION) // ternary
 	{
 		llvm::BasicBlock* ifblock = llvm::BasicBlock::Create(__context, "ternif", func);
 		llvm::BasicBlock* elseblock = llvm::BasicBlock::Create(__context, "ternelse", func);
 		llvm::BasicBlock* endblock = llvm::BasicBlock::Create(__context, "terncont", func);
 
 		// first eval condition
-		node->_left->accept(this);
-		llvm::Value* cond = to_bool(pop());
+		llvm::Value* cond = to_bool(node->_left->accept(this));
 		_builder->CreateCondBr(cond, ifblock, elseblock);
 
 		// if block
 		_builder->SetInsertPoint(ifblock);
-		node->_middle->accept(this);
+		llvm::Value* ifval = node->_middle->accept(this);
 		ParsedType* casttype = node->_middle->_cast_to;
-		llvm::Value* ifval = create_cast(pop(), false, casttype->get_llvm_type(), casttype->is_signed());
+		ifval = create_cast(ifval, false, casttype->get_llvm_type(), casttype->is_signed());
 		_builder->CreateBr(endblock);
 		ifblock = _builder->GetInsertBlock(); // update ifblock
 
 		// else block
 		endblock->moveAfter(ifblock);
 		_builder->SetInsertPoint(elseblock);
-		node->_right->accept(this);
+		llvm::Value* elseval = node->_right->accept(this);
 		casttype = node->_right->_cast_to;
-		llvm::Value* elseval = create_cast(pop(), false, casttype->get_llvm_type(), casttype->is_signed());
+		elseval = create_cast(elseval, false, casttype->get_llvm_type(), casttype->is_signed());
 		_builder->CreateBr(endblock);
 		elseblock = _builder->GetInsertBlock(); // update elseblock
 
@@ -639,10 +955,10 @@ VISIT(LogicalNode)
 		phi->addIncoming(ifval, ifblock);
 		phi->addIncoming(elseval, elseblock);
 
-		// push(create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false));
-		push(phi);
+		// return create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false);
+		return phi;
 	}
-	else if(node->_token.type == TOKEN_PIPE_PIPE) // or
+	else if(node->_optype == TOKEN_PIPE_PIPE) // or
 	{
 		llvm::Function* func = _builder->GetInsertBlock()->getParent();
 		llvm::BasicBlock* start = _builder->GetInsertBlock();
@@ -650,14 +966,11 @@ VISIT(LogicalNode)
 		llvm::BasicBlock* orcont = llvm::BasicBlock::Create(__context, "orcont", func);
 
 		// first condition
-		node->_left->accept(this);
-		// llvm::Value* resulta = to_bool(pop());
-		_builder->CreateCondBr(to_bool(pop()), orcont, ortwo);
+		_builder->CreateCondBr(to_bool(node->_left->accept(this)), orcont, ortwo);
 
 		// second condition (only evaluated if first is false)
 		_builder->SetInsertPoint(ortwo);
-		node->_right->accept(this);
-		llvm::Value* result = to_bool(pop());
+		llvm::Value* result = to_bool(node->_right->accept(this));
 		_builder->CreateBr(orcont);
 		ortwo = _builder->GetInsertBlock(); // update ortwo block
 
@@ -670,37 +983,32 @@ VISIT(LogicalNode)
 		phi->addIncoming(_builder->getTrue(), start);
 		phi->addIncoming(result, ortwo);
 
-		// push(create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false));
-		push(phi);
+		// return create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false);
+		return phi;
 	}
-	else if(node->_token.type == TOKEN_CARET_CARET) // xor
+	else if(node->_optype == TOKEN_CARET_CARET) // xor
 	{
 		// first condition
-		node->_left->accept(this);
-		llvm::Value* lhs = to_bool(pop());
+		llvm::Value* lhs = to_bool(node->_left->accept(this));
 
 		// second condition (only evaluated if first is true)
-		node->_right->accept(this);
-		llvm::Value* rhs = to_bool(pop());
+		llvm::Value* rhs = to_bool(node->_right->accept(this));
 
 		// decide on result
-		push(_builder->CreateXor(lhs, rhs));
+		return _builder->CreateXor(lhs, rhs);
 	}
-	else if(node->_token.type == TOKEN_AND_AND) // and
+	else if(node->_optype == TOKEN_AND_AND) // and
 	{
 		llvm::BasicBlock* start = _builder->GetInsertBlock();
 		llvm::BasicBlock* andtwo = llvm::BasicBlock::Create(__context, "andtwo", func);
 		llvm::BasicBlock* andcont = llvm::BasicBlock::Create(__context, "andcont", func);
 
 		// first condition
-		node->_left->accept(this);
-		// llvm::Value* resulta = to_bool(pop());
-		_builder->CreateCondBr(to_bool(pop()), andtwo, andcont);
+		_builder->CreateCondBr(to_bool(node->_left->accept(this)), andtwo, andcont);
 
 		// second condition (only evaluated if first is true)
 		_builder->SetInsertPoint(andtwo);
-		node->_right->accept(this);
-		llvm::Value* result = to_bool(pop());
+		llvm::Value* result = to_bool(node->_right->accept(this));
 		_builder->CreateBr(andcont);
 		andtwo = _builder->GetInsertBlock(); // update andtwo block
 
@@ -713,185 +1021,197 @@ VISIT(LogicalNode)
 		phi->addIncoming(_builder->getFalse(), start);
 		phi->addIncoming(result, andtwo);
 
-		// push(create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false));
-		push(phi);
+		// return create_cast(phi, false, lexical_type_to_llvm(node->_cast_to), false);
+		return phi;
 	}
 	
 	else THROW_INTERNAL_ERROR("during code generation");
+	return nullptr;
 }
 
 VISIT(BinaryNode)
 {
 	DEBUG_EMITLOC();
-	node->_left->accept(this);
-	node->_right->accept(this);
+	llvm::Value* left = node->_left->accept(this);
+	llvm::Value* right = node->_right->accept(this);
 
 	ParsedType* resulttype = node->_left->_cast_to;
 	
-	llvm::Value* right = create_cast(pop(), resulttype->is_signed(), resulttype->get_llvm_type(), resulttype->is_signed());
-	llvm::Value* left = create_cast(pop(), resulttype->is_signed(), resulttype->get_llvm_type(), resulttype->is_signed());
+	left = create_cast(left, resulttype->is_signed(), resulttype->get_llvm_type(), resulttype->is_signed());
+	right = create_cast(right, resulttype->is_signed(), resulttype->get_llvm_type(), resulttype->is_signed());
+
+	// pointers are compared as addresses, whatever they point to
+	if(resulttype->is_pointer()) switch(node->_optype)
+	{
+		case TOKEN_EQUAL_EQUAL:   return _builder->CreateICmpEQ(left, right, "peqtmp");
+		case TOKEN_SLASH_EQUAL:   return _builder->CreateICmpNE(left, right, "pnetmp");
+		case TOKEN_GREATER_EQUAL: return _builder->CreateICmpUGE(left, right, "pgetmp");
+		case TOKEN_LESS_EQUAL:    return _builder->CreateICmpULE(left, right, "pletmp");
+		case TOKEN_GREATER:       return _builder->CreateICmpUGT(left, right, "pgttmp");
+		case TOKEN_LESS:          return _builder->CreateICmpULT(left, right, "plttmp");
+		default: break;
+	}
 
 	switch(node->_optype)
 	{
 		case TOKEN_PIPE: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateOr(left, right, "bbotmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateOr(left, right, "ibotmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateOr(left, right,"fbotmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateOr(left, right, "cbotmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateOr(left, right, "bbotmp");
+				case TYPE_INTEGER:   return _builder->CreateOr(left, right, "ibotmp");
+				case TYPE_FLOAT:     return _builder->CreateOr(left, right,"fbotmp");
+				case TYPE_CHARACTER: return _builder->CreateOr(left, right, "cbotmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_CARET: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateXor(left, right, "bbxtmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateXor(left, right, "ibxtmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateXor(left, right,"fbxtmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateXor(left, right, "cbxtmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateXor(left, right, "bbxtmp");
+				case TYPE_INTEGER:   return _builder->CreateXor(left, right, "ibxtmp");
+				case TYPE_FLOAT:     return _builder->CreateXor(left, right,"fbxtmp");
+				case TYPE_CHARACTER: return _builder->CreateXor(left, right, "cbxtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_AND: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateAnd(left, right, "bbatmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateAnd(left, right, "ibatmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateAnd(left, right,"fbatmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateAnd(left, right, "cbatmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateAnd(left, right, "bbatmp");
+				case TYPE_INTEGER:   return _builder->CreateAnd(left, right, "ibatmp");
+				case TYPE_FLOAT:     return _builder->CreateAnd(left, right,"fbatmp");
+				case TYPE_CHARACTER: return _builder->CreateAnd(left, right, "cbatmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 
 		case TOKEN_EQUAL_EQUAL: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpEQ(left, right, "beqtmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpEQ(left, right, "ieqtmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpOEQ(left, right,"feqtmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpEQ(left, right, "ceqtmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpEQ(left, right, "beqtmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpEQ(left, right, "ieqtmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpOEQ(left, right,"feqtmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpEQ(left, right, "ceqtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_SLASH_EQUAL: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpNE(left, right, "bnetmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpNE(left, right, "inetmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpONE(left, right,"fnetmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpNE(left, right, "cnetmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpNE(left, right, "bnetmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpNE(left, right, "inetmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpONE(left, right,"fnetmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpNE(left, right, "cnetmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 
 		case TOKEN_GREATER_EQUAL: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpSGE(left, right, "bgetmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpSGE(left, right, "igetmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpOGE(left, right,"fgetmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpUGE(left, right, "cgetmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpSGE(left, right, "bgetmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpSGE(left, right, "igetmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpOGE(left, right,"fgetmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpUGE(left, right, "cgetmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_LESS_EQUAL: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpSLE(left, right, "bletmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpSLE(left, right, "iletmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpOLE(left, right,"fletmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpULE(left, right, "cletmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpSLE(left, right, "bletmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpSLE(left, right, "iletmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpOLE(left, right,"fletmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpULE(left, right, "cletmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_GREATER: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpSGT(left, right, "bgttmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpSGT(left, right, "igttmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpOGT(left, right,"fgttmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpUGT(left, right, "cgttmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpSGT(left, right, "bgttmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpSGT(left, right, "igttmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpOGT(left, right,"fgttmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpUGT(left, right, "cgttmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_LESS: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateICmpSLT(left, right, "blttmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateICmpSLT(left, right, "ilttmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFCmpOLT(left, right,"flttmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateICmpULT(left, right, "clttmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateICmpSLT(left, right, "blttmp");
+				case TYPE_INTEGER:   return _builder->CreateICmpSLT(left, right, "ilttmp");
+				case TYPE_FLOAT:     return _builder->CreateFCmpOLT(left, right,"flttmp");
+				case TYPE_CHARACTER: return _builder->CreateICmpULT(left, right, "clttmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 
 		case TOKEN_GREATER_GREATER: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateLShr(left, right, "bsrtmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateLShr(left, right, "isrtmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateLShr(left, right,"fsrtmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateLShr(left, right, "csrtmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateLShr(left, right, "bsrtmp");
+				case TYPE_INTEGER:   return _builder->CreateLShr(left, right, "isrtmp");
+				case TYPE_FLOAT:     return _builder->CreateLShr(left, right,"fsrtmp");
+				case TYPE_CHARACTER: return _builder->CreateLShr(left, right, "csrtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 		case TOKEN_LESS_LESS: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateShl(left, right, "bsltmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateShl(left, right, "isltmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateShl(left, right,"fsltmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateShl(left, right, "csltmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateShl(left, right, "bsltmp");
+				case TYPE_INTEGER:   return _builder->CreateShl(left, right, "isltmp");
+				case TYPE_FLOAT:     return _builder->CreateShl(left, right,"fsltmp");
+				case TYPE_CHARACTER: return _builder->CreateShl(left, right, "csltmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
 			}
 			break;
 
 		case TOKEN_PLUS: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateAdd(left, right, "baddtmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateAdd(left, right, "iaddtmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFAdd(left, right,"faddtmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateAdd(left, right, "caddtmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateAdd(left, right, "baddtmp");
+				case TYPE_INTEGER:   return _builder->CreateAdd(left, right, "iaddtmp");
+				case TYPE_FLOAT:     return _builder->CreateFAdd(left, right,"faddtmp");
+				case TYPE_CHARACTER: return _builder->CreateAdd(left, right, "caddtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		case TOKEN_MINUS: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateSub(left, right, "bsubmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateSub(left, right, "isubmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFSub(left, right,"fsubmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateSub(left, right, "csubmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateSub(left, right, "bsubmp");
+				case TYPE_INTEGER:   return _builder->CreateSub(left, right, "isubmp");
+				case TYPE_FLOAT:     return _builder->CreateFSub(left, right,"fsubmp");
+				case TYPE_CHARACTER: return _builder->CreateSub(left, right, "csubmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		case TOKEN_STAR: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateMul(left, right, "bmultmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateMul(left, right, "imultmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFMul(left, right,"fmultmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateMul(left, right, "cmultmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateMul(left, right, "bmultmp");
+				case TYPE_INTEGER:   return _builder->CreateMul(left, right, "imultmp");
+				case TYPE_FLOAT:     return _builder->CreateFMul(left, right,"fmultmp");
+				case TYPE_CHARACTER: return _builder->CreateMul(left, right, "cmultmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		case TOKEN_SLASH: switch(AS_LEX(resulttype))
 			{
-				case TYPE_BOOL:   	 push(_builder->CreateSDiv(left, right, "bdivtmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateSDiv(left, right, "idivtmp")); break;
-				case TYPE_FLOAT:     push(_builder->CreateFDiv(left, right,"fdivtmp")); break;
-				case TYPE_CHARACTER: push(_builder->CreateUDiv(left, right, "cdivtmp")); break;
+				case TYPE_BOOL:   	 return _builder->CreateSDiv(left, right, "bdivtmp");
+				case TYPE_INTEGER:   return _builder->CreateSDiv(left, right, "idivtmp");
+				case TYPE_FLOAT:     return _builder->CreateFDiv(left, right,"fdivtmp");
+				case TYPE_CHARACTER: return _builder->CreateUDiv(left, right, "cdivtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		
 		default: THROW_INTERNAL_ERROR("during code generation");
 	}
+	return nullptr;
 }
 
 VISIT(CastNode)
 {
 	DEBUG_EMITLOC();
-	node->_expr->accept(this);
-	llvm::Value* val = pop();
-	push(create_cast(val, false, node->_type->get_llvm_type(), node->_type->is_signed()));
+	llvm::Value* val = node->_expr->accept(this);
+	return create_cast(val, false, node->_type->get_llvm_type(), node->_type->is_signed());
 }
 
 VISIT(UnaryNode)
 {
 	DEBUG_EMITLOC();
-	node->_expr->accept(this);
+	llvm::Value* value = node->_expr->accept(this);
 	ParsedType* parsedtype = node->_expr->_cast_to;
 	llvm::Type* casttype = parsedtype->get_llvm_type();
-	llvm::Value* value = pop();
 
 	switch(node->_optype)
 	{
@@ -899,82 +1219,77 @@ VISIT(UnaryNode)
 		{
 			// if(casttype->isPointerTy())
 				// value = _builder->CreateLoad(casttype->getPointerTo(), value, "predtmp");
-			push(_builder->CreateLoad(casttype, value, "dereftmp"));
-			break;
+			return _builder->CreateLoad(casttype, value, "dereftmp");
 		}
 		case TOKEN_AND:
 		{
-			push(value);
-			// push(_builder->CreatePtrToInt(value, casttype, "addrtmp"));
-			break;
+			return value;
+			// return _builder->CreatePtrToInt(value, casttype, "addrtmp");
 		}
 		case TOKEN_BANG:
 		{
-			push(_builder->CreateNot(to_bool(value)));
-			break;
+			return _builder->CreateNot(to_bool(value));
 		}
 
 		case TOKEN_MINUS: switch(AS_LEX(node->_expr->_cast_to))
 			{
-				case TYPE_INTEGER:   push(_builder->CreateNeg(value, "inegtmp")); break;
+				case TYPE_INTEGER:   return _builder->CreateNeg(value, "inegtmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		case TOKEN_PLUS_PLUS: switch(AS_LEX(node->_expr->_cast_to))
 			{
-				case TYPE_CHARACTER: push(_builder->CreateAdd(value, llvm::ConstantInt::get(casttype, 1), "cinctmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateAdd(value, llvm::ConstantInt::get(casttype, 1), "iinctmp")); break;
-				case TYPE_FLOAT: 	 push(_builder->CreateFAdd(value, llvm::ConstantFP::get(casttype, 1), "finctmp")); break;
+				case TYPE_CHARACTER: return _builder->CreateAdd(value, llvm::ConstantInt::get(casttype, 1), "cinctmp");
+				case TYPE_INTEGER:   return _builder->CreateAdd(value, llvm::ConstantInt::get(casttype, 1), "iinctmp");
+				case TYPE_FLOAT: 	 return _builder->CreateFAdd(value, llvm::ConstantFP::get(casttype, 1), "finctmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		case TOKEN_MINUS_MINUS: switch(AS_LEX(node->_expr->_cast_to))
 			{
-				case TYPE_CHARACTER: push(_builder->CreateSub(value, llvm::ConstantInt::get(casttype, 1), "cdectmp")); break;
-				case TYPE_INTEGER:   push(_builder->CreateSub(value, llvm::ConstantInt::get(casttype, 1), "idectmp")); break;
-				case TYPE_FLOAT: 	 push(_builder->CreateFSub(value, llvm::ConstantFP::get(casttype, 1), "fdectmp")); break;
+				case TYPE_CHARACTER: return _builder->CreateSub(value, llvm::ConstantInt::get(casttype, 1), "cdectmp");
+				case TYPE_INTEGER:   return _builder->CreateSub(value, llvm::ConstantInt::get(casttype, 1), "idectmp");
+				case TYPE_FLOAT: 	 return _builder->CreateFSub(value, llvm::ConstantFP::get(casttype, 1), "fdectmp");
 				default: THROW_INTERNAL_ERROR("during code generation");
-			} 
+			}
 			break;
 		
 		default: THROW_INTERNAL_ERROR("during code generation");
 	}
+	return nullptr;
 }
 
 VISIT(GroupingNode)
 {
 	DEBUG_EMITLOC();
-	node->_expr->accept(this);
 	// ParsedType* casttype = node->_cast_to;
-	// push(create_cast(pop(), false, casttype->get_llvm_type(), casttype->is_signed()));
-	// push(pop());
+	// return create_cast(node->_expr->accept(this), false, casttype->get_llvm_type(), casttype->is_signed());
+	return node->_expr->accept(this);
 }
 
 VISIT(SubscriptNode)
 {
 	DEBUG_EMITLOC();
-	node->_expr->accept(this);
-	llvm::Value* ptr = pop();
+	llvm::Value* ptr = node->_expr->accept(this);
 
-	node->_index->accept(this);
-	llvm::Value* index = pop();
+	llvm::Value* index = node->_index->accept(this);
 
 	llvm::Value* gep = _builder->CreateInBoundsGEP(ptr, index, "sgeptmp");
 
 	// ParsedType* casttype = node->_cast_to;
-	// push(create_cast(pop(), false, casttype->get_llvm_type(), casttype->is_signed()));
-	push(_builder->CreateLoad(gep, "subscrtmp"));
+	// return create_cast(_builder->CreateLoad(gep, "subscrtmp"), false, casttype->get_llvm_type(), casttype->is_signed());
+	return _builder->CreateLoad(gep, "subscrtmp");
 }
 
 
 VISIT(LiteralNode)
 {
 	DEBUG_EMITLOC();
-	ParsedType* type = from_token_type(node->_token.type);
+	ParsedType* type = from_token_type(node->_literal_type);
 	// llvm::Value* constant;
 	llvm::Constant* constant = nullptr;
 
-	switch(node->_token.type)
+	switch(node->_literal_type)
 	{
 		case TOKEN_INTEGER:
 			constant = llvm::ConstantInt::get(type->get_llvm_type(), node->_int_value, false);
@@ -987,7 +1302,7 @@ VISIT(LiteralNode)
 			break;
 		case TOKEN_STRING:
 		{
-			string str = tools::escstr(node->_string_value);
+			string str = tools::escstr(string(node->_string_value.start, node->_string_value.length));
 			llvm::Type* chartype = _builder->getInt8Ty();
 
 			vector<llvm::Constant *> chars(str.length());
@@ -1019,8 +1334,8 @@ VISIT(LiteralNode)
 	}
 
 	// ParsedType* casttype = node->_cast_to;
-	// push(create_cast(constant, type->is_signed(), casttype->get_llvm_type(), casttype->is_signed()));
-	push(constant);
+	// return create_cast(constant, type->is_signed(), casttype->get_llvm_type(), casttype->is_signed());
+	return constant;
 }
 
 VISIT(ArrayNode)
@@ -1039,8 +1354,7 @@ VISIT(ArrayNode)
 	for(int i = 0; i < node->_elements.size(); i++)
 	{
 		ExprNode* element = node->_elements[i];
-		element->accept(this);
-		llvm::Value* val = pop();
+		llvm::Value* val = element->accept(this);
 
 		_builder->CreateStore(val, ptr);
 		
@@ -1049,33 +1363,22 @@ VISIT(ArrayNode)
 			ptr, llvm::ConstantInt::get(__context, llvm::APInt(64, 1, false)), "arrgeptmp");
 	}
 	
-	push(_builder->CreateInBoundsGEP(arr, (llvm::Value*[]){idx0, idx0}, "arrgeptmp"));
+	return _builder->CreateInBoundsGEP(arr, (llvm::Value*[]){idx0, idx0}, "arrgeptmp");
 }
 
 VISIT(SizeOfNode)
 {
 	DEBUG_EMITLOC();
 	llvm::TypeSize size = _top_module->getDataLayout().getTypeAllocSize(node->_type->get_llvm_type());
-	push(llvm::ConstantInt::get(node->_cast_to->get_llvm_type(), size, false));
+	return llvm::ConstantInt::get(node->_cast_to->get_llvm_type(), size, false);
 }
 
 VISIT(ReferenceNode)
 {
 	DEBUG_EMITLOC();
 
-	llvm::Value* var = nullptr;
-	ParsedType* type = nullptr;
-
-	if(node->_token.type == TOKEN_VARIABLE_REF)
-	{
-		var = _named_values[node->_variable].first;
-		type = _named_values[node->_variable].second;
-	}
-	else if(node->_token.type == TOKEN_PARAMETER_REF)
-	{
-		var = _named_values[to_string(node->_parameter)].first;
-		type = _named_values[to_string(node->_parameter)].second;
-	}
+	llvm::Value* var = get_slot(node->_slot).first;
+	ParsedType* type = get_slot(node->_slot).second;
 
 	ASSERT_OR_THROW_INTERNAL_ERROR(var, "during reference retrieval");
 	ASSERT_OR_THROW_INTERNAL_ERROR(type, "during reference retrieval");
@@ -1083,14 +1386,14 @@ VISIT(ReferenceNode)
 
 	if(node->_cast_to->_keep_as_reference)
 	{
-		// push the raw pointer
-		DEBUG_PRINT_F_MSG("Kept %.*s as reference.", node->_token.length, node->_token.start);
-		push(var);
+		// return the raw pointer
+		DEBUG_PRINT_F_MSG("Kept %.*s as reference.", node->token().length, node->token().start);
+		return var;
 	}
 	else
 	{
 		llvm::LoadInst* load = _builder->CreateLoad(type->get_llvm_type(), var, "loadtmp");
-		push(load);
+		return load;
 	}
 }
 
@@ -1103,22 +1406,20 @@ VISIT(CallNode)
 	vector<llvm::Value*> args;
 	for(int i = 0; i < node->_arguments.size(); i++)
 	{
-		node->_arguments[i]->accept(this);
+		llvm::Value* arg = node->_arguments[i]->accept(this);
 
 		if(i < node->_func_params_count)
 		{
 			llvm::Type* casttype = callee->getArg(i)->getType();
-			args.push_back(create_cast(pop(), false, casttype, node->_expected_arg_types[i]->is_signed()));
+			args.push_back(create_cast(arg, false, casttype, node->_expected_arg_types[i]->is_signed()));
 		}
-		else args.push_back(pop());
+		else args.push_back(arg);
 	}
 
 	if(AS_LEX(node->_ret_type) == TYPE_VOID && !node->_ret_type->is_pointer())
-		push(_builder->CreateCall(callee, args));
-	else push(_builder->CreateCall(callee, args, "calltmp"));
+		return _builder->CreateCall(callee, args);
+	else return _builder->CreateCall(callee, args, "calltmp");
 }
 
 #undef VISIT
 #undef ERROR_AT
-#undef SCOPE_UP
-#undef SCOPE_DOWN
\ No newline at end of file
@@ -46,7 +46,7 @@ llvm::DISubprogram* DebugInfoBuilder::create_subprogram(FuncDeclNode* node, llvm
 
 	llvm::DISubprogram* subprog = _dbuilder->createFunction(
 		file_unit, node->_identifier, node->_identifier,
-		file_unit, node->_token.line, get_function_type(node, file_unit), node->_token.line,
+		file_unit, node->token().line, get_function_type(node, file_unit), node->token().line,
 		llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition); //, params);
 
 	return subprog;
@@ -1,5 +1,13 @@
 #include "error.hpp"
 
+thread_local string* __diagnostics = nullptr;
+
+void print_diagnostic(string text)
+{
+	cerr << text;
+	if(__diagnostics) *__diagnostics += text;
+}
+
 void ErrorDispatcher::print_token_marked(Token *token, ccp color)
 {
 	string tokenline = "";
@@ -8,13 +16,8 @@ void ErrorDispatcher::print_token_marked(Token *token, ccp color)
 	// get offset of token (first char)
 	ptrdiff_t token_offset = token->start - token->source;
 
-	// find first newline before token
-	ptrdiff_t tok_ln_begin;
-	{
-		tok_ln_begin = token_offset;
-		while(tok_ln_begin > 0 && token->source[tok_ln_begin] != '\n') tok_ln_begin--;
-		tok_ln_begin++; // skip newline itself
-	}
+	// find the start of the token's line
+	ptrdiff_t tok_ln_begin = get_token_line_start(token);
 
 	// find first newline after token
 	ptrdiff_t tok_ln_end = token_offset + token->length;
@@ -70,42 +73,42 @@ void ErrorDispatcher::print_token_marked(Token *token, ccp color)
 	}
 
 	// print it all out
-	cerr << tokenline << endl;
-	cerr << markerline << endl;
+	print_diagnostic(tokenline + "\n");
+	print_diagnostic(markerline + "\n");
 }
 
 void ErrorDispatcher::print_line_marked(uint line_no, string line, ccp color)
 {
 	string prefix = tools::fstr(" %3d| ", line_no);
 
-	cerr << prefix + line << endl;
+	print_diagnostic(prefix + line + "\n");
 
-	cerr << COLOR_RED;
-	cerr << string(prefix.length(), ' ') + ('^' + string(line.length() - 1, '~'));
-	cerr << COLOR_NONE;
-	cerr << endl;
+	print_diagnostic(COLOR_RED);
+	print_diagnostic(string(prefix.length(), ' ') + ('^' + string(line.length() - 1, '~')));
+	print_diagnostic(COLOR_NONE);
+	print_diagnostic("\n");
 }
 
 void ErrorDispatcher::__dispatch(ccp color, ccp prompt, ccp message)
 {
-	cerr << tools::fstr("[evi] %s%s" COLOR_NONE ": %s",
-						color, prompt, message) << endl;
+	print_diagnostic(tools::fstr("[evi] %s%s" COLOR_NONE ": %s\n",
+						color, prompt, message));
 }
 
 void ErrorDispatcher::__dispatch_at_token(ccp color, Token* token, ccp prompt, ccp message)
 {
-	fprintf(stderr, "[%s:%d] %s%s" COLOR_NONE ": %s\n",
-			token->file->c_str(), token->line, color, prompt, message);
+	print_diagnostic(tools::fstr("[%s:%d] %s%s" COLOR_NONE ": %s\n",
+			token->file->c_str(), token->line, color, prompt, message));
 }
 
 // if line == 0 lineno is omitted. likewise with filename
 void ErrorDispatcher::__dispatch_at_line(ccp color, uint line, ccp filename, ccp prompt, ccp message)
 {
-	if(line) fprintf(stderr, "[%s:%d] %s%s" COLOR_NONE ": %s\n",
-				filename ? filename : "???", line, color, prompt, message);
+	if(line) print_diagnostic(tools::fstr("[%s:%d] %s%s" COLOR_NONE ": %s\n",
+				filename ? filename : "???", line, color, prompt, message));
 
-	else fprintf(stderr, "[%s] %s%s" COLOR_NONE ": %s\n",
-				filename ? filename : "???", color, prompt, message);
+	else print_diagnostic(tools::fstr("[%s] %s%s" COLOR_NONE ": %s\n",
+				filename ? filename : "???", color, prompt, message));
 }
 
 
@@ -3,7 +3,7 @@
 
 // =====================================================
 
-static uint counter_value = 0;
+static thread_local uint counter_value = 0;
 
 // =====================================================
 
@@ -77,6 +77,9 @@ void initialize_state_singleton(Preprocessor* p)
 {
 	State::_p = p;
 	State::_initialized = true;
+
+	// a thread might preprocess several files one after another
+	counter_value = 0;
 }
 
 void Preprocessor::initialize_builtin_macros()
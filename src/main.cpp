@@ -3,6 +3,8 @@
 
 #include <argp.h>
 #include <regex>
+#include <thread>
+#include <atomic>
 #include "lint.hpp"
 
 #include "common.hpp"
@@ -11,15 +13,18 @@
 #include "preprocessor.hpp"
 #include "codegen.hpp"
 #include "visualizer.hpp"
+#include "timing.hpp"
+#include "cache.hpp"
 
 // ================= arg stuff =======================
 
 const char *argp_program_version = APP_NAME " " APP_VERSION;
 const char *argp_program_bug_address = EMAIL;
-static char args_doc[] = "files...";
+static char args_doc[] = "files...\nrun file [args...]";
 
 #define MAX_INFILES 0xff
 #define MAX_LINKED 0xff
+#define MAX_CODEGEN_THREADS 0xff
 
 #define ARG_EMIT_LLVM 1
 #define ARG_GEN_AST 2
@@ -29,6 +34,15 @@ static char args_doc[] = "files...";
 #define ARG_LINT_TAB_WIDTH 6
 #define ARG_STD_DIR 7
 #define ARG_STATLIB_DIR 8
+#define ARG_TIME_PHASES 9
+#define ARG_TIME_TRACE 10
+#define ARG_EXTERNAL_LD 11
+#define ARG_NO_CACHE 12
+#define ARG_CACHE_STATS 13
+#define ARG_TARGET_CPU 14
+#define ARG_TARGET_FEATURES 15
+#define ARG_PROFILE_GENERATE 16
+#define ARG_PROFILE_USE 17
 
 struct arguments
 {
@@ -44,7 +58,14 @@ struct arguments
 	bool compile_only = false;
 	bool output_given = false;
 	bool debug = false;
+	bool external_ld = false;
+	bool lto = false;
+	int codegen_threads = 1;
+	bool run = false;
+	vector<string> run_args;
 	OptimizationType optimization = OPTIMIZE_O3;
+	string target_cpu = DEFAULT_TARGET_CPU;
+	string target_features;
 };
 
 static struct argp_option options[] =
@@ -56,14 +77,26 @@ static struct argp_option options[] =
 
 	{"output",  			'o', 			 "OUTFILE",   0, "Output to OUTFILE instead of to standard output."},
 	{0,  					'O', 			 "LEVEL",     0, "Set the optimization level."},
+	{0,  					'f', 			 "FLAG",      0, "Enable code generation FLAG ('lto' to optimize together with the stdlib)."},
 	{"link", 				'l', 			 "FILE", 	  0, "Link with FILE."},
+	{"jobs", 				'j', 			 "N", 		  0, "Split up the code generation of each file over N threads."},
+	{"target-cpu", 			ARG_TARGET_CPU,  "CPU", 	  0, "Generate code for CPU ('native' for the host cpu)."},
+	{"march", 				ARG_TARGET_CPU,  "CPU", 	  OPTION_ALIAS, 0},
+	{"target-features", 	ARG_TARGET_FEATURES, "FEATURES", 0, "Enable or disable the target FEATURES (e.g. '+avx2,-bmi')."},
 	{"include", 			'i', 			 "DIRECTORY", 0, "Add DIRECTORY to include search path."},
+	{"external-ld", 		ARG_EXTERNAL_LD, 0, 		  0, "Link by invoking " LD_PATH " instead of the embedded lld."},
 
 	{"debug", 				'd', 			 0, 		  0, "Generate source-level debug information."},
 	{"preprocess-only", 	'p', 			 0, 		  0, "Preprocess only but do not compile or link."},
 	{"compile-only", 		'c', 			 0, 		  0, "Compile and assemble but do not link."},
 	{"emit-llvm",  			ARG_EMIT_LLVM, 	 0, 		  0, "Emit llvm IR instead of an executable."},
 	{"generate-ast",  		ARG_GEN_AST, 	 0, 		  0, "Generate AST image (for debugging purposes)."},
+	{"profile-generate", 	ARG_PROFILE_GENERATE, "FILE", OPTION_ARG_OPTIONAL, "Instrument the program to write a profile (to FILE) when it's run."},
+	{"profile-use", 		ARG_PROFILE_USE, "FILE", 	  0, "Optimize using the profile data in FILE (.profdata)."},
+	{"time-phases",  		ARG_TIME_PHASES, "FORMAT", 	  OPTION_ARG_OPTIONAL, "Report the time and memory used by each compilation phase ('json' for JSON)."},
+	{"time-trace",  		ARG_TIME_TRACE,  "FILE", 	  0, "Write a Chrome trace-event JSON of the compilation to FILE."},
+	{"no-cache",  			ARG_NO_CACHE, 	 0, 		  0, "Do not use or update the compilation cache."},
+	{"cache-stats",  		ARG_CACHE_STATS, 0, 		  0, "Report the compilation cache hits and misses."},
 
 	{"print-ld-flags",  	ARG_LD_FLAGS, 	 0, 		  0, "Display the flags passed to the linker."},
 	{"print-stdlib-dir", 	ARG_STD_DIR, 	 0, 		  0, "Display the standard library header directory."},
@@ -136,6 +169,32 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 		arguments->optimization = (OptimizationType)(arg[0]);
 		break;
 	}
+	case 'f':
+	{
+		if(strcmp(arg, "lto"))
+		{
+			cerr << "[evi] CLI Error: Invalid code generation flag: " << arg << endl;
+			cerr << "[evi] Note: Valid flags: 'lto'" << endl;
+			ABORT(STATUS_CLI_ERROR);
+		}
+
+		arguments->lto = true;
+		break;
+	}
+	case 'j':
+	{
+		char* end;
+		long threads = strtol(arg, &end, 10);
+		if(*end || threads < 1 || threads > MAX_CODEGEN_THREADS)
+		{
+			cerr << "[evi] CLI Error: Invalid number of code generation threads: " << arg << endl;
+			cerr << tools::fstr("[evi] Note: Valid numbers: 1 to %d", MAX_CODEGEN_THREADS) << endl;
+			ABORT(STATUS_CLI_ERROR);
+		}
+
+		arguments->codegen_threads = threads;
+		break;
+	}
 	case 'l':
 	{
 		if(arguments->linkedc == MAX_LINKED)
@@ -167,6 +226,16 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 		break;
 	}
 
+	case ARG_EXTERNAL_LD:
+		arguments->external_ld = true;
+		break;
+	case ARG_TARGET_CPU:
+		arguments->target_cpu = arg;
+		break;
+	case ARG_TARGET_FEATURES:
+		arguments->target_features = arg;
+		break;
+
 	case 'd':
 		arguments->debug = true;
 		break;
@@ -182,6 +251,32 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 	case ARG_GEN_AST:
 		arguments->generate_ast = true;
 		break;
+	case ARG_PROFILE_GENERATE:
+		pgo_args.generate = true;
+		pgo_args.generate_file = arg;
+		break;
+	case ARG_PROFILE_USE:
+		pgo_args.use_file = arg;
+		break;
+	case ARG_TIME_PHASES:
+		if(arg && strcmp(arg, "json") && strcmp(arg, "text"))
+		{
+			cerr << "[evi] CLI Error: Invalid phase timing format: " << arg << endl;
+			cerr << "[evi] Note: Valid formats: 'text', 'json'" << endl;
+			ABORT(STATUS_CLI_ERROR);
+		}
+		timing_args.time_phases = true;
+		timing_args.json = arg && !strcmp(arg, "json");
+		break;
+	case ARG_TIME_TRACE:
+		timing_args.trace_file = arg;
+		break;
+	case ARG_NO_CACHE:
+		cache_args.disabled = true;
+		break;
+	case ARG_CACHE_STATS:
+		cache_args.print_stats = true;
+		break;
 
 	case ARG_LD_FLAGS:
 	{
@@ -248,6 +343,16 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 
 	case ARGP_KEY_ARG:
 	{
+		// 'evi run file args...' passes everything after the file on to the program
+		if(arguments->run)
+		{
+			arguments->infiles[arguments->infilesc++] = arg;
+			arguments->run_args.push_back(arg);
+			for(; state->next < state->argc; state->next++)
+				arguments->run_args.push_back(state->argv[state->next]);
+			break;
+		}
+
 		if(arguments->infilesc == MAX_INFILES)
 		{
 			cerr << tools::fstr("[evi] Error: Cannot compile more than %d evi files.", MAX_INFILES) << endl;
@@ -272,101 +377,202 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 
 // ================================
 
-void check_main_function(AST* astree)
+// returns true if the main function is declared (or doesn't need to be)
+bool check_main_function(AST* astree)
 {
-	if(lint_args.type != LINT_NONE) return;
+	if(lint_args.type != LINT_NONE) return true;
 
 	// search for main func declaration
 	FuncDeclNode* mainfunc = nullptr;
 	for(auto& node : *astree)
-		if(!mainfunc && dynamic_cast<FuncDeclNode*>(node) && ((FuncDeclNode*)node)->_identifier == "main")
+		if(!mainfunc && node && node->_kind == NODE_FUNC_DECL && ((FuncDeclNode*)node)->_identifier == "main")
 				mainfunc = (FuncDeclNode*)node;
 
 	ParsedType* rettype = PTYPE(TYPE_INTEGER);
 	ParsedType* argone = PTYPE(TYPE_INTEGER);
-	ParsedType* argtwo = PTYPE(TYPE_CHARACTER)->copy_pointer_to()->copy_pointer_to();
-	argtwo->_is_constant = true;
+	ParsedType* argtwo = PTYPE(TYPE_CHARACTER)->copy_pointer_to()->copy_pointer_to()->copy_change_constant(true);
 
-	if(!mainfunc) // main func not found
-		ErrorDispatcher().warning("Warning", "Function " COLOR_BOLD "'main'" COLOR_NONE " not declared.");
+	if(!mainfunc) // main func not found (might be in another file)
+		return false;
 
-	else if(!mainfunc->_ret_type->eq(rettype, true)) // wrong return type
-		ErrorDispatcher().warning_at_token(&mainfunc->_token, "Warning",
+	Token token = mainfunc->token();
+	if(!mainfunc->_ret_type->eq(rettype, true)) // wrong return type
+		ErrorDispatcher().warning_at_token(&token, "Warning",
 			"Return type of function " COLOR_BOLD "'main'" COLOR_NONE " is not an integer type.");
 
 	else if(mainfunc->_params.size() != 0 && (mainfunc->_params.size() != 2 ||
 			!mainfunc->_params[0]->eq(argone, true) || !mainfunc->_params[1]->eq(argtwo, true))) // incorrect args
-		ErrorDispatcher().warning_at_token(&mainfunc->_token, "Warning", 
+		ErrorDispatcher().warning_at_token(&token, "Warning", 
 			"Function " COLOR_BOLD "'main'" COLOR_NONE " does not have parameters similar to " COLOR_BOLD "'i32 !chr**'" COLOR_NONE ".");
+	
+	return true;
 }
 
-int main(int argc, char **argv)
+// get the output file name derived from the given input file
+string get_default_outfile(struct arguments* arguments, ccp infile)
 {
-	// ========= argument stuff =========
-
-	struct arguments arguments;
-	include_paths_count = 0;
+	// strip the extension, but not a dot in a directory name
+	string outfile = infile;
+	size_t dot = outfile.find_last_of('.');
+	size_t slash = outfile.find_last_of('/');
+	if(dot != string::npos && (slash == string::npos || dot > slash + 1))
+		outfile.erase(dot);
+
+	if(arguments->preprocess_only) return outfile + ".evii";
+	else if(arguments->compile_only && !arguments->emit_llvm) return outfile + ".o";
+	else if(arguments->emit_llvm) return outfile + ".ll";
+	return outfile;
+}
 
-	/* Where the magic happens */
-	if(argp_parse(&argp, argc, argv, 0, 0, &arguments)) ABORT(STATUS_CLI_ERROR);
+// what -flto internalizes. a single file that is linked is the whole program
+LTOType get_lto_type(struct arguments* arguments)
+{
+	bool linking = !arguments->preprocess_only && !arguments->compile_only && !arguments->emit_llvm;
+	if(!arguments->lto) return LTO_NONE;
+	return linking && arguments->infilesc == 1 ? LTO_WHOLE_PROGRAM : LTO_STDLIB;
+}
 
-	// figure out output file name
-	if(!arguments.output_given)
+// everything besides the preprocessed source that affects the output
+string get_cache_options(struct arguments* arguments)
+{
+	// the lto type, not just -flto: a whole program object can't be linked with others
+	ccp kind = arguments->run ? "bitcode" : arguments->emit_llvm ? "llvm" : "object";
+	string options = tools::fstr("%s -O%c -d%d -lto%d %s %s %s", kind, arguments->optimization, arguments->debug, get_lto_type(arguments),
+								 llvm::sys::getDefaultTargetTriple().c_str(), arguments->target_cpu.c_str(),
+								 arguments->target_features.c_str());
+
+	// a changed profile means different code
+	if(pgo_args.generate) options += tools::fstr(" -pgo-gen %s", pgo_args.generate_file ? pgo_args.generate_file : "");
+	else if(pgo_args.use_file)
 	{
-		arguments.outfile = strdup(arguments.infilesc ? arguments.infiles[0] : arguments.linked[0]);
-		arguments.outfile = strtok(arguments.outfile, ".");
-
-		if(arguments.preprocess_only)
-			arguments.outfile = strdup(tools::fstr("%s.evii", arguments.outfile).c_str());
-		else if(arguments.compile_only && !arguments.emit_llvm)
-			arguments.outfile = strdup(tools::fstr("%s.o", arguments.outfile).c_str());
-		else if(arguments.emit_llvm) 
-			arguments.outfile = strdup(tools::fstr("%s.ll", arguments.outfile).c_str());
+		auto profile_md5 = llvm::sys::fs::md5_contents(pgo_args.use_file);
+		options += tools::fstr(" -pgo-use %s", profile_md5 ? profile_md5->digest().c_str() : "");
 	}
 
-	// ===================================
+	return options;
+}
 
-	// temp
-	if(!arguments.infilesc)
+// ================================
+
+typedef struct
+{
+	Status status = STATUS_SUCCESS;
+	bool has_main = false;
+	vector<string> objfiles;
+	string bitcode;
+} CompilationResult;
+
+// outputs a cached artifact like compile_file would have
+Status output_cached(struct arguments* arguments, ccp infile, ccp outfile, CacheEntry* entry, CompilationResult* result)
+{
+	bool linking = !arguments->preprocess_only && !arguments->compile_only && !arguments->emit_llvm;
+	result->has_main = entry->has_main;
+	cerr << entry->diagnostics;
+
+	if(!linking) tools::writef(outfile, entry->data);
+	else if(arguments->run) result->bitcode = entry->data;
+	else if(!arguments->external_ld)
 	{
-		cerr << "[evi] CLI Error: Expected at least one Evi file." << endl;
-		ABORT(STATUS_CLI_ERROR);
+		result->objfiles.emplace_back();
+		return CodeGenerator::write_memory_object(infile, entry->data, &result->objfiles.back());
+	}
+	else
+	{
+		result->objfiles.push_back(tools::mktempf(tools::fstr(TEMP_OBJ_FILE_TEMPLATE, infile), TEMP_OBJ_FILE_SUFFIX_LEN));
+		tools::writef(result->objfiles.back(), entry->data);
 	}
+	return STATUS_SUCCESS;
+}
 
-	// ===================================
+// runs the whole pipeline for a single file (on one of the worker threads)
+void compile_file(struct arguments* arguments, ccp infile, CompilationResult* result)
+{
+	bool linking = !arguments->preprocess_only && !arguments->compile_only && !arguments->emit_llvm;
+	string outfile_name = arguments->infilesc > 1 && !linking ? get_default_outfile(arguments, infile) : arguments->outfile;
+	ccp outfile = outfile_name.c_str();
 
-	AST astree;
-	ccp source = strdup(tools::readf(arguments.infiles[0]).c_str());
+	// each thread has its own llvm context and therefore its own types
 	init_builtin_evi_types();
-	Status status;
 
-	#define ABORT_IF_UNSUCCESSFULL() if(status != STATUS_SUCCESS) { if(lint_args.type == LINT_GET_DIAGNOSTICS) \
-									 { LINT_OUTPUT_END_PLAIN_ARRAY(); cout << lint_output; exit(0); } ABORT(status); }
-	if(lint_args.type == LINT_GET_DIAGNOSTICS) LINT_OUTPUT_START_PLAIN_ARRAY();
+	// the ast and its types live until the end of the compilation
+	Arena arena;
+	__arena = &arena;
+	FileTable files;
+	__files = &files;
+
+	AST astree;
+	size_t source_size;
+	ccp source = tools::mapf(infile, &source_size);
+
+	#define RETURN_IF_UNSUCCESSFULL() if(result->status != STATUS_SUCCESS) { if(lint_args.type == LINT_GET_DIAGNOSTICS) \
+									  { LINT_OUTPUT_END_PLAIN_ARRAY(); cout << lint_output; exit(0); } return; }
 
 
 	// preprocess
+	PhaseTimer prepr_timer("preprocess", infile);
 	Preprocessor* prepr = new Preprocessor();
-	status = prepr->preprocess(arguments.infiles[0], &source);
-	ABORT_IF_UNSUCCESSFULL();
-	if(arguments.preprocess_only) { tools::writef(arguments.outfile, source); return STATUS_SUCCESS; }
+	SourceMap source_map;
+	ccp mapped_source = source;
+	result->status = prepr->preprocess(infile, &source, &source_map);
+	tools::unmapf(mapped_source, source_size);
+	prepr_timer.count(count(source, source + strlen(source), '\n'), "lines");
+	prepr_timer.stop();
+	RETURN_IF_UNSUCCESSFULL();
+	if(arguments->preprocess_only) { tools::writef(outfile, source_map.insert_markers(source)); return; }
+
+
+	// an identical compilation might be cached already
+	bool caching = lint_args.type == LINT_NONE && !arguments->generate_ast;
+	string cachekey = caching ? cache_key(source, &source_map, get_cache_options(arguments)) : "";
+	CacheEntry entry;
+	if(caching && cache_lookup(cachekey, &entry))
+	{
+		DEBUG_PRINT_F_MSG("Using cached compilation of %s (%s)", infile, cachekey.c_str());
+		result->status = output_cached(arguments, infile, outfile, &entry, result);
+		free((void*)source);
+		return;
+	}
+
+	// the warnings from here on are cached along with the output
+	string diagnostics;
+	__diagnostics = &diagnostics;
+
+
+	// scan program
+	PhaseTimer scan_timer("scan", infile);
+	TokenBuffer tokens(source, &source_map);
+	__tokens = &tokens;
+	scan_timer.count(tokens.size(), "tokens");
+	scan_timer.stop();
 
 
 	// parse program
+	PhaseTimer parser_timer("parse", infile);
+	size_t node_count = ast_node_count;
 	Parser* parser = new Parser();
-	status = parser->parse(arguments.infiles[0], source, &astree);
-	ABORT_IF_UNSUCCESSFULL();
+	result->status = parser->parse(infile, &tokens, &astree);
+	node_count = ast_node_count - node_count;
+	parser_timer.count(node_count, "nodes");
+	parser_timer.stop();
+	RETURN_IF_UNSUCCESSFULL();
 
 
-	// check for function @main i32 (...)
-	if(!arguments.compile_only && !arguments.emit_llvm && !arguments.generate_ast)
-		check_main_function(&astree);
+	// check for function @main i32 (...). this is done even if the file isn't
+	// linked now, because its cache entry might be linked later
+	if(!arguments->generate_ast)
+	{
+		PhaseTimer main_timer("check main", infile);
+		result->has_main = check_main_function(&astree);
+	}
 
 
 	// type check
+	PhaseTimer checker_timer("type check", infile);
 	TypeChecker* checker = new TypeChecker();
-	status = checker->check(arguments.infiles[0], source, &astree);
-	ABORT_IF_UNSUCCESSFULL();
+	result->status = checker->check(infile, source, &astree);
+	checker_timer.count(node_count, "nodes");
+	checker_timer.stop();
+	RETURN_IF_UNSUCCESSFULL();
 
 
 	// finish linting
@@ -385,29 +591,196 @@ int main(int argc, char **argv)
 
 
 	// generate visualization
-	if(arguments.generate_ast)
+	if(arguments->generate_ast)
 	{
-		ASTVisualizer().visualize(string(arguments.infiles[0]) + ".svg", &astree);
-		cout << "[evi] AST image written to \"" + string(arguments.infiles[0]) + ".svg\"." << endl;
-		exit(STATUS_SUCCESS);
+		ASTVisualizer().visualize(string(infile) + ".svg", &astree);
+		cout << "[evi] AST image written to \"" + string(infile) + ".svg\"." << endl;
+		return;
 	}
 
 
 	// codegen
-	CodeGenerator* codegen = new CodeGenerator();
-	status = codegen->generate(arguments.infiles[0], arguments.outfile, source,
-							   &astree, arguments.optimization, arguments.debug);
-	ABORT_IF_UNSUCCESSFULL();
-
+	CodeGenerator* codegen = new CodeGenerator(arguments->target_cpu, arguments->target_features, arguments->codegen_threads);
+	result->status = codegen->generate(infile, outfile, source,
+									   &astree, arguments->optimization, arguments->debug, get_lto_type(arguments));
+	RETURN_IF_UNSUCCESSFULL();
+
+
+	// output (objects that are to be linked stay in memory,
+	// unless the external linker needs a temporary file)
+	PhaseTimer emit_timer("emit", infile);
+	if(arguments->compile_only && !arguments->emit_llvm) result->status = codegen->emit_object(outfile);
+	else if(arguments->emit_llvm) result->status = codegen->emit_llvm(outfile);
+	else if(arguments->run) result->status = codegen->emit_bitcode_in_memory(&result->bitcode);
+	else if(!arguments->external_ld) result->status = codegen->emit_object_in_memory(&result->objfiles);
+	else
+	{
+		result->objfiles.push_back(tools::mktempf(tools::fstr(TEMP_OBJ_FILE_TEMPLATE, infile), TEMP_OBJ_FILE_SUFFIX_LEN));
+		DEBUG_PRINT_F_MSG("Emitting object file... (%s)", result->objfiles[0].c_str());
+		result->status = codegen->emit_object(result->objfiles[0].c_str());
+	}
+	emit_timer.stop();
 
-	// output
-	if(arguments.compile_only && !arguments.emit_llvm) status = codegen->emit_object(arguments.outfile);
-	else if(arguments.emit_llvm) status = codegen->emit_llvm(arguments.outfile);
-	else status = codegen->emit_binary(arguments.outfile, (ccp*)arguments.linked, arguments.linkedc);
-	ABORT_IF_UNSUCCESSFULL();
+	__diagnostics = nullptr;
+	if(caching && result->status == STATUS_SUCCESS && arguments->run)
+		cache_store_data(cachekey, result->bitcode, result->has_main, diagnostics);
+	else if(caching && result->status == STATUS_SUCCESS && result->objfiles.size() <= 1)
+		cache_store(cachekey, result->objfiles.size() ? result->objfiles[0].c_str() : outfile, result->has_main, diagnostics);
 
 
 	free((void*)source);
+	#undef RETURN_IF_UNSUCCESSFULL
+}
+
+int main(int argc, char **argv)
+{
+	// ========= argument stuff =========
+
+	struct arguments arguments;
+	include_paths_count = 0;
+
+	// 'evi run ...' is parsed in order so that the
+	// program's own arguments are left alone
+	int argp_flags = 0;
+	if(argc > 1 && !strcmp(argv[1], "run"))
+	{
+		arguments.run = true;
+		argp_flags |= ARGP_IN_ORDER;
+		argv[1] = argv[0]; argv++; argc--;
+	}
+
+	/* Where the magic happens */
+	if(argp_parse(&argp, argc, argv, argp_flags, 0, &arguments)) ABORT(STATUS_CLI_ERROR);
+
+	// 'native' is resolved here already so that the cache
+	// never mixes up code for different hosts
+	CodeGenerator::resolve_target(&arguments.target_cpu, &arguments.target_features);
+
+	// figure out output file name
+	if(!arguments.output_given)
+		arguments.outfile = strdup(get_default_outfile(&arguments,
+			arguments.infilesc ? arguments.infiles[0] : arguments.linked[0]).c_str());
+
+	// ===================================
+
+	// temp
+	if(!arguments.infilesc)
+	{
+		cerr << "[evi] CLI Error: Expected at least one Evi file." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+
+	bool linking = !arguments.preprocess_only && !arguments.compile_only && !arguments.emit_llvm;
+	if(arguments.run && (!linking || arguments.generate_ast || arguments.output_given))
+	{
+		cerr << "[evi] CLI Error: Cannot specify '-o', '-p', '-c', '--emit-llvm' or '--generate-ast' with 'run'." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(pgo_args.generate && pgo_args.use_file)
+	{
+		cerr << "[evi] CLI Error: Cannot specify both '--profile-generate' and '--profile-use'." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(pgo_args.generate && arguments.optimization == OPTIMIZE_On)
+	{
+		cerr << "[evi] CLI Error: Cannot specify '--profile-generate' with '-On' (no passes, so no instrumentation)." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(pgo_args.generate && arguments.run)
+	{
+		cerr << "[evi] CLI Error: Cannot specify '--profile-generate' with 'run'." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(pgo_args.generate && linking && !strlen(PROFILE_RT_LIB))
+	{
+		cerr << "[evi] CLI Error: '--profile-generate' is unavailable as this build has no profile runtime." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(pgo_args.use_file && !llvm::sys::fs::exists(pgo_args.use_file))
+	{
+		cerr << "[evi] CLI Error: Profile data file \"" << pgo_args.use_file << "\" does not exist." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+	if(arguments.infilesc > 1 && arguments.output_given && !linking)
+	{
+		cerr << "[evi] CLI Error: Cannot specify output file with '-p', '-c' or '--emit-llvm' with multiple Evi files." << endl;
+		ABORT(STATUS_CLI_ERROR);
+	}
+
+	// ===================================
+
+	// linting only ever concerns the first file
+	int filesc = lint_args.type == LINT_NONE ? arguments.infilesc : 1;
+	if(lint_args.type == LINT_GET_DIAGNOSTICS) LINT_OUTPUT_START_PLAIN_ARRAY();
+
+	// compile the files on a pool of threads (at most one per core)
+	// that each take the next file until none are left
+	timing_initialize_thread();
+	vector<CompilationResult> results(filesc);
+	atomic<int> nextfile(0);
+	int workersc = min<int>(filesc, max(thread::hardware_concurrency(), 1u));
+	vector<thread> workers;
+	for(int w = 0; w < workersc; w++) workers.push_back(thread([&arguments, &results, &nextfile, filesc]() {
+		timing_initialize_thread();
+		for(int i = nextfile++; i < filesc; i = nextfile++)
+			compile_file(&arguments, arguments.infiles[i], &results[i]);
+		timing_finish_thread();
+	}));
+	for(thread& worker : workers) worker.join();
+
+	// abort with the status of the first file that failed
+	for(CompilationResult& result : results) if(result.status != STATUS_SUCCESS)
+	{
+		if(arguments.external_ld) for(CompilationResult& r : results)
+			for(string& objfile : r.objfiles) remove(objfile.c_str());
+		ABORT(result.status);
+	}
+
+	cache_report();
+	if(!linking || arguments.generate_ast) return timing_report();
+
+
+	// check if one of the files declared main
+	bool has_main = false;
+	for(CompilationResult& result : results) has_main |= result.has_main;
+	if(!has_main && arguments.run)
+	{
+		ErrorDispatcher().error("JIT Error", "Function " COLOR_BOLD "'main'" COLOR_NONE " not declared.");
+		ABORT(STATUS_CODEGEN_ERROR);
+	}
+	else if(!has_main) ErrorDispatcher().warning("Warning", "Function " COLOR_BOLD "'main'" COLOR_NONE " not declared.");
+
+
+	// run the program instead of linking it
+	if(arguments.run)
+	{
+		vector<string> bitcodes;
+		for(CompilationResult& result : results) bitcodes.push_back(result.bitcode);
+
+		int exitcode;
+		Status status = CodeGenerator::run_jit(&bitcodes, (ccp*)arguments.linked, arguments.linkedc,
+											   arguments.run_args, &exitcode);
+		if(status != STATUS_SUCCESS) ABORT(status);
+
+		timing_report();
+		return exitcode;
+	}
+
+
+	// link all objects together
+	vector<ccp> objects;
+	for(CompilationResult& result : results)
+		for(string& objfile : result.objfiles) objects.push_back(objfile.c_str());
+	PhaseTimer link_timer("link", arguments.outfile);
+	Status status = CodeGenerator::emit_binary(arguments.outfile, objects.data(), objects.size(),
+											   (ccp*)arguments.linked, arguments.linkedc, arguments.external_ld);
+	link_timer.stop();
+	if(status != STATUS_SUCCESS) ABORT(status);
+
+	status = timing_report();
+	if(status != STATUS_SUCCESS) ABORT(status);
+
+
 	DEBUG_PRINT_MSG("Exited sucessfully.");
 	return STATUS_SUCCESS;
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "parser.hpp"
 #include "tools.hpp"
 
+thread_local size_t ast_node_count = 0;
+thread_local const TokenBuffer* __tokens = nullptr;
+
 // ====================== errors =======================
 
 void Parser::error_at(Token *token, string message)
@@ -76,7 +79,7 @@ void Parser::advance(bool can_trigger_lint)
 
 	for (;;)
 	{
-		_current = _scanner.scanToken();
+		_current = _tokens->get(_next_token++);
 
 		if(can_trigger_lint && (*_current.file == _main_file)
 		&& (lint_args.type == LINT_GET_FUNCTIONS || lint_args.type == LINT_GET_VARIABLES || lint_args.type == LINT_GET_DECLARATION)
@@ -86,10 +89,6 @@ void Parser::advance(bool can_trigger_lint)
 		else if (_current.type == TOKEN_ERROR)
 			error_at_current(_current.start);
 
-		else if(_current.type == TOKEN_LINE_MARKER)
-			// _error_dispatcher.set_filename(strdup(_current.start));
-			{}
-
 		else break;
 	}
 }
@@ -123,17 +122,8 @@ ParsedType* Parser::consume_type(string msg)
 
 	// get base type
 	CONSUME_OR_RET_NULL(TOKEN_TYPE, msg);
-	string typestr = PREV_TOKEN_STR;
-	if (!IS_EVI_TYPE(typestr))
-	{
-		error(tools::fstr("Invalid type: '%s'.", typestr.c_str()));
-		return ParsedType::new_invalid();
-	}
-
-	ParsedType* type = PTYPE(
-		GET_EVI_TYPE(typestr)->_default_type,
-		GET_EVI_TYPE(typestr));
-	type->_is_constant = constant;
+	EviType* evi_type = _previous.evi_type;
+	ParsedType* type = PTYPE(evi_type->_default_type, evi_type)->copy_change_constant(constant);
 
 	// can be pointer
 	while(match(TOKEN_STAR)) type = type->copy_pointer_to();
@@ -170,38 +160,21 @@ void Parser::generate_lint()
 		{
 			LINT_OUTPUT_START_PLAIN_OBJECT();
 
-			// output props of functions in current scope
-			for(auto const& func : _current_scope.functions)
+			// output props of all visible functions
+			for(auto const& func : _symbols.get_functions())
 			{
 				LINT_OUTPUT_OBJECT_START(func.first);
-				LINT_OUTPUT_PAIR("return type", func.second.ret_type->to_string());
+				LINT_OUTPUT_PAIR("return type", func.second->ret_type->to_string());
 
 				LINT_OUTPUT_ARRAY_START("parameters");
-				for(auto const& param : func.second.params)
+				for(auto const& param : func.second->params)
 					LINT_OUTPUT_ARRAY_ITEM(param->to_string());
 				LINT_OUTPUT_ARRAY_END();
-				LINT_OUTPUT_PAIR_F("variadic", func.second.variadic ? "true" : "false", %s);
+				LINT_OUTPUT_PAIR_F("variadic", func.second->variadic ? "true" : "false", %s);
 
 				LINT_OUTPUT_OBJECT_END();
 			}
 
-			// and now of all other scopes
-			for(auto scope = _scope_stack.rbegin(); scope != _scope_stack.rend(); scope++)
-				for(auto const& func : scope->functions)
-				{
-					LINT_OUTPUT_OBJECT_START(func.first);
-					LINT_OUTPUT_PAIR("return type", func.second.ret_type->to_string());
-
-					LINT_OUTPUT_ARRAY_START("parameters");
-					for(auto const& param : func.second.params)
-						LINT_OUTPUT_ARRAY_ITEM(param->to_string());
-					LINT_OUTPUT_ARRAY_END();
-					LINT_OUTPUT_PAIR_F("variadic", func.second.variadic ? "true" : "false", %s);
-
-					LINT_OUTPUT_OBJECT_END();
-				}						
-				
-
 			LINT_OUTPUT_END_PLAIN_OBJECT();
 			break;
 		}
@@ -209,15 +182,11 @@ void Parser::generate_lint()
 		{
 			LINT_OUTPUT_START_PLAIN_OBJECT();
 
-			for(int i = 0; i < _current_scope.func_props.params.size(); i++)
-				LINT_OUTPUT_PAIR(tools::fstr("%d", i), _current_scope.func_props.params[i]->to_string());
-
-			for (auto const& var : _current_scope.variables)
-				LINT_OUTPUT_PAIR(var.first, var.second.type->to_string());
+			if(_current_function) for(int i = 0; i < _current_function->params.size(); i++)
+				LINT_OUTPUT_PAIR(tools::fstr("%d", i), _current_function->params[i]->to_string());
 
-			for (auto scope = _scope_stack.rbegin(); scope != _scope_stack.rend(); scope++)
-				for(auto const& var : scope->variables)
-					LINT_OUTPUT_PAIR(var.first, var.second.type->to_string());
+			for(auto const& var : _symbols.get_variables())
+				LINT_OUTPUT_PAIR(var.first, var.second->type->to_string());
 
 			LINT_OUTPUT_END_PLAIN_OBJECT();
 			break;
@@ -248,16 +217,17 @@ void Parser::generate_lint()
 			{
 				name.erase(0, 1);
 				if(!check_variable(name)) INVALID()
-				else decltok = get_variable_props(name).token;
+				else decltok = get_variable_props(name)->token;
 			}
 			else if(token.type == TOKEN_PARAMETER_REF)
 			{
-				decltok = _current_scope.func_props.token;
+				if(!_current_function) INVALID()
+				else decltok = _current_function->token;
 			}
 			else if(token.type == TOKEN_IDENTIFIER)
 			{
 				if(!check_function(name)) INVALID()
-				else decltok = get_function_props(name).token;
+				else decltok = get_function_props(name)->token;
 			}
 			else INVALID()
 
@@ -280,56 +250,44 @@ void Parser::generate_lint()
 // ======================= state =======================
 
 // returns nullptr if not found
-Parser::VarProperties Parser::get_variable_props(string name)
+VarProperties* Parser::get_variable_props(string name)
 {
-	if(_current_scope.variables.find(name) != _current_scope.variables.end())
-		return _current_scope.variables.at(name);
-
-	for (auto scope = _scope_stack.rbegin(); scope != _scope_stack.rend(); scope++)
-	{
-		if (scope->variables.find(name) != scope->variables.end())
-			return scope->variables.at(name);
-	}
-	return { nullptr };
+	return _symbols.get_variable(name);
 }
 
-// returns with invalid = true if not found
-Parser::FuncProperties Parser::get_function_props(string name)
+// returns nullptr if not found
+FuncProperties* Parser::get_function_props(string name)
 {
-	if(_current_scope.functions.find(name) != _current_scope.functions.end())
-		return _current_scope.functions.at(name);
-
-	for (auto scope = _scope_stack.rbegin(); scope != _scope_stack.rend(); scope++)
-	{
-		if (scope->functions.find(name) != scope->functions.end())
-			return scope->functions.at(name);
-	}
-	return {.invalid = true};
+	return _symbols.get_function(name);
 }
 
 // checks if the given variable already exists
 bool Parser::check_variable(string name)
 {
-	if(get_variable_props(name).type == nullptr)
-		return false;
-	return true;
+	return get_variable_props(name) != nullptr;
 }
 
 // checks if the given function already exists
 bool Parser::check_function(string name)
 {
-	if(get_function_props(name).invalid)
-		return false;
-	return true;
+	return get_function_props(name) != nullptr;
 }
 
-void Parser::add_variable(Token* identtoken, ParsedType* type)
+// returns the slot the variable is bound to (index -1 if invalid)
+Slot Parser::add_variable(Token* identtoken, ParsedType* type)
 {
 	string name = string(identtoken->start, identtoken->length);
+	bool global = !_symbols.depth();
 
 	if(check_function(name)) error_at(identtoken, "Function with identical name already exists in current scope.");
 	else if (check_variable(name)) error_at(identtoken, "Variable already exists in current scope.");
-	else _current_scope.variables.insert(pair<string, VarProperties>(name, { type->copy(), *identtoken }));
+	else
+	{
+		Slot slot = {global ? _global_slots++ : _local_slots++, global};
+		_symbols.add_variable(name, { type->copy(), *identtoken, slot });
+		return slot;
+	}
+	return {-1, global};
 }
 
 void Parser::add_function(Token* identtoken, FuncProperties properties)
@@ -337,37 +295,26 @@ void Parser::add_function(Token* identtoken, FuncProperties properties)
 	string name = string(identtoken->start, identtoken->length);
 
 	if (check_variable(name)) error_at(identtoken, "Variable with identical name already exists in current scope.");
-	else if(check_function(name))
+	else if(FuncProperties* props = get_function_props(name))
 	{
-		FuncProperties props = get_function_props(name);
-		if(props.defined) error_at(identtoken, "Function already defined in current scope.");
+		if(props->defined) error_at(identtoken, "Function already defined in current scope.");
 		else if(!properties.defined) error_at(identtoken, "Function already declared in current scope.");
-		else if(props.ret_type != properties.ret_type || props.params != properties.params)
+		else if(props->ret_type != properties.ret_type || props->params != properties.params)
 			error_at(identtoken, "Function signature doesn't match declaration.");
 
-		_current_scope.functions.at(name).defined = true;
+		props->defined = true;
 	}
-	else _current_scope.functions.insert(pair<string, FuncProperties>(name, properties));
+	else _symbols.add_function(name, properties);
 }
 
 void Parser::scope_up()
 {
-	int depth = _current_scope.depth + 1;
-	FuncProperties func_props = _current_scope.func_props;
-	
-	_scope_stack.push_back(_current_scope);
-	_current_scope = Scope{
-		depth,
-		map<string, VarProperties>(),
-		func_props,
-		map<string, FuncProperties>(),
-		Scope::SCOPE_NORMAL};
+	_symbols.scope_up();
 }
 
 void Parser::scope_down()
 {
-	_current_scope = _scope_stack[_scope_stack.size() - 1];
-	_scope_stack.pop_back();
+	_symbols.scope_down();
 }
 
 void Parser::synchronize(bool toplevel)
@@ -484,7 +431,7 @@ StmtNode* Parser::function_declaration()
 	{
 		// declaration
 		add_function(&nametok, {ret_type, params, is_variadic, false, false, tok});
-		return new FuncDeclNode(tok, name, ret_type, is_static, params, is_variadic, nullptr);
+		return new FuncDeclNode(tok, name, ret_type, is_static, ArenaVector<ParsedType*>(params.begin(), params.end()), is_variadic, nullptr);
 	}
 	else
 	{
@@ -492,13 +439,20 @@ StmtNode* Parser::function_declaration()
 		FuncProperties props = {ret_type, params, is_variadic, true, false, tok};
 		add_function(&nametok, props);
 
+		FuncProperties* outer = _current_function;
+		int outer_slots = _local_slots;
 		scope_up();
-		_current_scope.func_props = props;
+		_current_function = &props;
+		// the parameters take the first slots
+		_local_slots = params.size();
 		
 		StmtNode* body = statement();
+		int slot_count = _local_slots;
 
 		scope_down();
-		return new FuncDeclNode(tok, name, ret_type, is_static, params, is_variadic, body);
+		_current_function = outer;
+		_local_slots = outer_slots;
+		return new FuncDeclNode(tok, name, ret_type, is_static, ArenaVector<ParsedType*>(params.begin(), params.end()), is_variadic, body, slot_count);
 	}
 }
 
@@ -525,19 +479,20 @@ StmtNode* Parser::variable_declaration()
 	// get type
 	ParsedType* type = consume_type(nametokens.size() > 1 ? "Expected type after identifiers." : "Expected type after identifier.");
 	if(!type || type->is_invalid()) return nullptr;
-	type->_is_reference = true;
+	type = type->copy_as_reference();
 
 	// add to locals for parser to use
-	for(Token& tok : nametokens) add_variable(&tok, type);
-	bool is_global = !_current_scope.depth;
+	vector<Slot> slots;
+	for(Token& tok : nametokens) slots.push_back(add_variable(&tok, type));
+	bool is_global = !_symbols.depth();
 	vector<VarDeclNode*> decls;
 
 	// get initializers(s)?
 	if(match(TOKEN_SEMICOLON))
 	{
 		// declarations
-		for(Token& name : nametokens) decls.push_back(
-			new VarDeclNode(tok, string(name.start, name.length), type, is_static, nullptr, is_global));
+		for(int i = 0; i < nametokens.size(); i++) decls.push_back(new VarDeclNode(tok,
+			string(nametokens[i].start, nametokens[i].length), type, is_static, nullptr, is_global, slots[i]));
 	}
 	else
 	{
@@ -547,7 +502,7 @@ StmtNode* Parser::variable_declaration()
 			ExprNode* expr = expression(is_global || is_static);
 			if(i + 1 < nametokens.size()) CONSUME_OR_RET_NULL(TOKEN_COMMA, "Expected ',' after expression.");
 			string name = string(nametokens[i].start, nametokens[i].length);
-			decls.push_back(new VarDeclNode(tok, name, type, is_static, expr, is_global));
+			decls.push_back(new VarDeclNode(tok, name, type, is_static, expr, is_global, slots[i]));
 		}
 		CONSUME_OR_RET_NULL(TOKEN_SEMICOLON, "Expected ';' after variable defenition.");
 	}
@@ -590,17 +545,19 @@ StmtNode* Parser::assign_statement()
 
 	CONSUME_OR_RET_NULL(TOKEN_IDENTIFIER, "Expected identifier after '='.");
 	string ident = PREV_TOKEN_STR;
-	if(!check_variable(ident)) error("Variable doesn't exist in current scope.");
+	VarProperties* props = get_variable_props(ident);
+	if(!props) error("Variable doesn't exist in current scope.");
 
-	VarProperties props = get_variable_props(ident);
-	if(props.type->is_constant())
+	ParsedType* type = props ? props->type : nullptr;
+	Slot slot = props ? props->slot : Slot{-1, false};
+	if(type && type->is_constant())
 	{
-		error(tools::fstr("Cannot assign to variable with constant-modified type '%s'.", props.type->to_c_string()));
+		error(tools::fstr("Cannot assign to variable with constant-modified type '%s'.", type->to_c_string()));
 		// return nullptr;
 	}
 
 	// allow subscript
-	vector<ExprNode*> subs = vector<ExprNode*>();
+	ArenaVector<ExprNode*> subs = ArenaVector<ExprNode*>();
 	while(match(TOKEN_LEFT_B_BRACE))
 	{
 		subs.push_back(expression());
@@ -610,7 +567,7 @@ StmtNode* Parser::assign_statement()
 	ExprNode* expr = expression();
 	CONSUME_OR_RET_NULL(TOKEN_SEMICOLON, "Expected ';' after expression.");
 
-	return new AssignNode(tok, ident, subs, expr, props.type);
+	return new AssignNode(tok, ident, subs, expr, type, slot);
 }
 
 StmtNode* Parser::if_statement()
@@ -652,12 +609,12 @@ StmtNode* Parser::return_statement()
 {
 	// return 	: "~" expression? ";"
 	Token tok = _previous;
-	if(match(TOKEN_SEMICOLON)) return new ReturnNode(tok, nullptr, _current_scope.func_props.ret_type);
+	if(match(TOKEN_SEMICOLON)) return new ReturnNode(tok, nullptr, _current_function ? _current_function->ret_type : nullptr);
 	else
 	{
 		ExprNode* expr = expression();
 		CONSUME_OR_RET_NULL(TOKEN_SEMICOLON, "Expected ';' after return statement.");
-		return new ReturnNode(tok, expr, _current_scope.func_props.ret_type);
+		return new ReturnNode(tok, expr, _current_function ? _current_function->ret_type : nullptr);
 	}
 }
 
@@ -687,209 +644,86 @@ StmtNode* Parser::expression_statement()
 
 ExprNode* Parser::expression(bool is_constexpr)
 {
-	// expression 	: ternary
-	return ternary(is_constexpr);
-}
-
-ExprNode* Parser::ternary(bool is_constexpr)
-{
-	// ternary		: logical_or ("?" expression ":" ternary)?
-
-	ExprNode* expr = logical_or(is_constexpr);
-
-	while(match(TOKEN_QUESTION))
-	{
-		Token tok = _previous;
-		ExprNode* middle = expression(is_constexpr);
-	
-		CONSUME_OR_RET_NULL(TOKEN_COLON, "Expect ':' after if-expression.");
-		ExprNode* right = ternary(is_constexpr);
-	
-		expr = new LogicalNode(tok, expr, right, middle);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::logical_or(bool is_constexpr)
-{
-	// logical_or		: logical_xor ("||" logical_xor)*
-	ExprNode* expr = logical_xor(is_constexpr);
-
-	while(match(TOKEN_PIPE_PIPE))
-	{
-		Token tok = _previous;
-		ExprNode* right = logical_xor(is_constexpr);
-		expr = new LogicalNode(tok, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::logical_xor(bool is_constexpr)
-{
-	// logical_or		: logical_and ("^^" logical_and)*
-	ExprNode* expr = logical_and(is_constexpr);
-
-	while(match(TOKEN_CARET_CARET))
-	{
-		Token tok = _previous;
-		ExprNode* right = logical_and(is_constexpr);
-		expr = new LogicalNode(tok, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::logical_and(bool is_constexpr)
-{
-	// logical_and	: bitwise_or ("&&" bitwise_or)*
-	ExprNode* expr = bitwise_or(is_constexpr);
-
-	while(match(TOKEN_AND_AND))
-	{
-		Token tok = _previous;
-		ExprNode* right = bitwise_or(is_constexpr);
-		expr = new LogicalNode(tok, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::bitwise_or(bool is_constexpr)
-{
-	// bitwise_or	: bitwise_xor ("|" bitwise_xor)*
-	ExprNode* expr = bitwise_xor(is_constexpr);
-
-	while(match(TOKEN_PIPE))
-	{
-		Token tok = _previous;
-		ExprNode* right = bitwise_xor(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::bitwise_xor(bool is_constexpr)
-{
-	// bitwise_xor	: bitwise_and ("^" bitwise_and)*
-	ExprNode* expr = bitwise_and(is_constexpr);
-
-	while(match(TOKEN_CARET))
-	{
-		Token tok = _previous;
-		ExprNode* right = bitwise_and(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::bitwise_and(bool is_constexpr)
-{
-	// bitwise_and	: equality ("&" equality)*
-	ExprNode* expr = equality(is_constexpr);
-
-	while(match(TOKEN_AND))
-	{
-		Token tok = _previous;
-		ExprNode* right = equality(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::equality(bool is_constexpr)
-{
-	// equality		: comparison (("/=" | "==") comparison)*
-	ExprNode* expr = comparison(is_constexpr);
-
-	while(match(TOKEN_SLASH_EQUAL) || match(TOKEN_EQUAL_EQUAL))
-	{
-		Token tok = _previous;
-		ExprNode* right = comparison(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
+	// expression 	: binary
+	return binary(PREC_TERNARY, is_constexpr);
 }
 
-ExprNode* Parser::comparison(bool is_constexpr)
+static Precedence infix_precedence(TokenType type)
 {
-	// comparison	: bitwise_shift ((">" | ">=" | "<" | "<=") bitwise_shift)*
-	ExprNode* expr = bitwise_shift(is_constexpr);
-
-	while(match(TOKEN_GREATER) || match(TOKEN_GREATER_EQUAL)
-	   || match(TOKEN_LESS)    || match(TOKEN_LESS_EQUAL))
+	switch(type)
 	{
-		Token tok = _previous;
-		ExprNode* right = bitwise_shift(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
+		case TOKEN_QUESTION:		return PREC_TERNARY;
+		case TOKEN_PIPE_PIPE:		return PREC_LOGICAL_OR;
+		case TOKEN_CARET_CARET:		return PREC_LOGICAL_XOR;
+		case TOKEN_AND_AND:			return PREC_LOGICAL_AND;
+		case TOKEN_PIPE:			return PREC_BITWISE_OR;
+		case TOKEN_CARET:			return PREC_BITWISE_XOR;
+		case TOKEN_AND:				return PREC_BITWISE_AND;
+		case TOKEN_SLASH_EQUAL:
+		case TOKEN_EQUAL_EQUAL:		return PREC_EQUALITY;
+		case TOKEN_GREATER:
+		case TOKEN_GREATER_EQUAL:
+		case TOKEN_LESS:
+		case TOKEN_LESS_EQUAL:		return PREC_COMPARISON;
+		case TOKEN_LESS_LESS:
+		case TOKEN_GREATER_GREATER:	return PREC_SHIFT;
+		case TOKEN_PLUS:
+		case TOKEN_MINUS:			return PREC_TERM;
+		case TOKEN_STAR:
+		case TOKEN_SLASH:			return PREC_FACTOR;
+		case TOKEN_ARROW:			return PREC_CAST;
+		default:					return PREC_NONE;
 	}
-
-	return expr;
 }
 
-ExprNode* Parser::bitwise_shift(bool is_constexpr)
+ExprNode* Parser::binary(Precedence min_prec, bool is_constexpr)
 {
-	// bitwise_shift	: term (("<<" | ">>") term)*
-	ExprNode* expr = term(is_constexpr);
-
-	while(match(TOKEN_LESS_LESS) || match(TOKEN_GREATER_GREATER))
-	{
-		Token tok = _previous;
-		ExprNode* right = term(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
+	// binary		: unary (INFIX_OP binary)*
+	// ternary		: binary "?" expression ":" binary
+	// cast			: binary "->" TYPE
+	// all infix operators are left-associative except for "?:"
 
-ExprNode* Parser::term(bool is_constexpr)
-{
-	// term		: factor (("-" | "+") factor)*
+	ExprNode* expr = unary(is_constexpr);
 
-	ExprNode* expr = factor(is_constexpr);
-	
-	while(match(TOKEN_PLUS) || match(TOKEN_MINUS))
+	for(;;)
 	{
-		Token tok = _previous;
-		ExprNode* right = factor(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::factor(bool is_constexpr)
-{
-	// factor		: cast (("/" | "*") cast)*
+		Precedence prec = infix_precedence(_current.type);
+		if(prec == PREC_NONE || prec < min_prec) break;
 
-	ExprNode* expr = cast(is_constexpr);
-	
-	while(match(TOKEN_STAR) || match(TOKEN_SLASH))
-	{
+		advance();
 		Token tok = _previous;
-		ExprNode* right = cast(is_constexpr);
-		expr = new BinaryNode(tok, tok.type, expr, right);
-	}
-
-	return expr;
-}
-
-ExprNode* Parser::cast(bool is_constexpr)
-{
-	// cast		: unary ("->" TYPE)*
-
-	ExprNode* expr = unary(is_constexpr);
 
-	while(match(TOKEN_ARROW))
-	{
-		Token tok = _previous;
-		ParsedType* type = consume_type("Expected type after '->'.");
-		expr = new CastNode(tok, expr, type);
+		switch(tok.type)
+		{
+			case TOKEN_QUESTION:
+			{
+				ExprNode* middle = expression(is_constexpr);
+				CONSUME_OR_RET_NULL(TOKEN_COLON, "Expect ':' after if-expression.");
+				ExprNode* right = binary(PREC_TERNARY, is_constexpr);
+				expr = new LogicalNode(tok, expr, right, middle);
+				break;
+			}
+			case TOKEN_ARROW:
+			{
+				ParsedType* type = consume_type("Expected type after '->'.");
+				expr = new CastNode(tok, expr, type);
+				break;
+			}
+			case TOKEN_PIPE_PIPE:
+			case TOKEN_CARET_CARET:
+			case TOKEN_AND_AND:
+			{
+				ExprNode* right = binary((Precedence)(prec + 1), is_constexpr);
+				expr = new LogicalNode(tok, expr, right);
+				break;
+			}
+			default:
+			{
+				ExprNode* right = binary((Precedence)(prec + 1), is_constexpr);
+				expr = new BinaryNode(tok, tok.type, expr, right);
+				break;
+			}
+		}
 	}
 
 	return expr;
@@ -1024,7 +858,7 @@ LiteralNode* Parser::literal()
 		case TOKEN_STRING:
 		{
 			//
-			return new LiteralNode(_previous, string(_previous.start + 1, _previous.length - 2));
+			return new LiteralNode(_previous, _previous.start + 1, _previous.length - 2);
 		}
 		default: THROW_INTERNAL_ERROR("during parsing");
 	}
@@ -1035,7 +869,7 @@ ArrayNode* Parser::array(bool is_constexpr)
 {
 	Token tok = _previous;
 
-	vector<ExprNode*> elements;
+	ArenaVector<ExprNode*> elements;
 	if(!check(TOKEN_RIGHT_BRACE)) do
 	{
 		// simple expression
@@ -1063,27 +897,29 @@ ReferenceNode* Parser::reference()
 	if(_previous.type == TOKEN_VARIABLE_REF)
 	{
 		string name = PREV_TOKEN_STR.erase(0, 1);
-		if(!check_variable(name)) error("Variable doesn't exist in current scope.");
-		return new ReferenceNode(_previous, name, -1, get_variable_props(name).type);
+		VarProperties* props = get_variable_props(name);
+		if(!props) error("Variable doesn't exist in current scope.");
+		return new ReferenceNode(_previous, name, -1, props ? props->type : nullptr,
+								 props ? props->slot : Slot{-1, false});
 	}
 	else if(_previous.type == TOKEN_PARAMETER_REF)
 	{
 		int intval = strtol(PREV_TOKEN_STR.erase(0, 1).c_str(), NULL, 10);
 		
-		int arity = _current_scope.func_props.params.size();
+		int arity = _current_function ? _current_function->params.size() : 0;
 		if(intval >= arity)
 		{
 			HOLD_PANIC();
 			error(tools::fstr("Parameter reference exceeds arity of %d.", arity));
-			if(!PANIC_HELD)
+			if(!PANIC_HELD && _current_function)
 			{
-				string name(_current_scope.func_props.token.start, _current_scope.func_props.token.length);
-				note_declaration("Surrounding function", name, &_current_scope.func_props.token);
+				string name(_current_function->token.start, _current_function->token.length);
+				note_declaration("Surrounding function", name, &_current_function->token);
 			}
 			return nullptr;
 		}
-		ParsedType* type = _current_scope.func_props.params[intval];
-		return new ReferenceNode(_previous, "", intval, type);
+		ParsedType* type = _current_function->params[intval];
+		return new ReferenceNode(_previous, "", intval, type, {intval, false});
 	}
 	THROW_INTERNAL_ERROR("during parsing");
 	return nullptr;
@@ -1097,10 +933,13 @@ CallNode* Parser::call()
 
 	CONSUME_OR_RET_NULL(TOKEN_LEFT_PAREN, "Expected '(' after identifier.");
 
-	if(!check_function(name)) error_at(&tok, "Function does not exist in current scope.");
+	// the arguments of unknown functions are still parsed
+	FuncProperties unknown = {.invalid = true};
+	FuncProperties* found = get_function_props(name);
+	if(!found) error_at(&tok, "Function does not exist in current scope.");
 
-	vector<ExprNode*> args;
-	FuncProperties funcprops = get_function_props(name);
+	ArenaVector<ExprNode*> args;
+	FuncProperties& funcprops = found ? *found : unknown;
 	int paramscount = funcprops.params.size();
 	
 	if(!check(TOKEN_RIGHT_PAREN)) do
@@ -1122,22 +961,24 @@ CallNode* Parser::call()
 
 	CONSUME_OR_RET_NULL(TOKEN_RIGHT_PAREN, "Expected ')' after arguments.");
 
-	vector<ParsedType*> lexparams; for(ParsedType*& p : funcprops.params) lexparams.push_back(p);
+	ArenaVector<ParsedType*> lexparams(funcprops.params.begin(), funcprops.params.end());
 	return funcprops.invalid ? nullptr : new CallNode(tok, name, args, funcprops.ret_type, lexparams, paramscount);
 }
 
 // ======================= misc. =======================
 
-Status Parser::parse(string infile, ccp source, AST* astree)
+Status Parser::parse(string infile, const TokenBuffer* tokens, AST* astree)
 {
-	// print_tokens_from_src(source);
 	_astree = astree;
 
 	// set members
-	_scanner = Scanner(source);
+	_tokens = tokens;
+	_next_token = 0;
 
-	_scope_stack = vector<Scope>();
-	_current_scope = Scope{0, map<string, VarProperties>(), {}, map<string, FuncProperties>()};
+	_symbols = SymbolTable();
+	_current_function = nullptr;
+	_global_slots = 0;
+	_local_slots = 0;
 
 	_had_error = false;
 	_panic_mode = false;
@@ -1,43 +1,49 @@
 #include "preprocessor.hpp"
 #include "tools.hpp"
+#include "timing.hpp"
+#include "simd.hpp"
 #include <regex>
 
 int include_paths_count = 0;
 char* include_paths[MAX_INCLUDE_PATHS] = {};
 
-#define SUBMIT_LINE(line) _lines.push_back(line)
-#define SUBMIT_LINE_F(format, ...) _lines.push_back(tools::fstr(format, __VA_ARGS__))
+#define SUBMIT_LINE(line) submit_line(line)
+#define SUBMIT_LINE_F(format, ...) submit_line(tools::fstr(format, __VA_ARGS__))
 #define IN_FALSE_BRANCH (_branches->size() && !_branches->top())
-#define LINE_MARKER(line) SUBMIT_LINE_F("# %d \"%s\"", line, _current_file.c_str())
+// the next output line is the line after the given one in the current file
+#define LINE_MARKER(line) _source_map->add_run(_output_length, _current_file, (line) + 1)
 #define CHECK_MACRO(macro) (_macros->find(macro) != _macros->end())
 #define FMT_PATH(path) (regex_replace(_current_file, regex(STDLIB_DIR), "<stdlib>"))
 
-Status Preprocessor::preprocess(string infile, ccp* source)
+Status Preprocessor::preprocess(string infile, ccp* source, SourceMap* map)
 {
 	// prepare sum shit
 	_source = *source;
-	_lines = vector<string>();
+	_source_map = map;
 	_current_file = infile;
 	_current_line_no = 0;
 	_branches = new stack<bool>();
-	_macros = new map<string, MacroProperties>();
+	_macros = new unordered_map<string, MacroProperties>();
 	_apply_depth = 0;
 	_error_dispatcher = ErrorDispatcher();
 	_had_error = false;
 
+	// the output is rarely much longer than the source (headers aside)
+	size_t length = strlen(_source);
+	_output_capacity = length + length / 8 + 1024;
+	_output_length = 0;
+	_output = (char*)malloc(_output_capacity);
+
 	initialize_state_singleton(this);
 	initialize_builtin_macros();
 
-	vector<string> lines = tools::split_string(string(*source), "\n");
-	lines = remove_comments(lines);
-
 	// do the actual preprocessing
 	LINE_MARKER(_current_line_no);
-	process_lines(lines);
+	process_lines(_source, _source + length);
 
-	// finish up
-	string result_source; for(string& ln : _lines) result_source += ln + "\n";
-	*source = strdup(result_source.c_str());
+	// finish up (the output buffer is handed over as is)
+	_output[_output_length] = '\0';
+	*source = _output;
 
 	DEBUG_PRINT_MSG("Preprocessor done!");
 
@@ -47,106 +53,178 @@ Status Preprocessor::preprocess(string infile, ccp* source)
 
 // ===============================================================
 
-void Preprocessor::process_lines(vector<string> lines)
+void Preprocessor::process_lines(ccp start, ccp end)
 {
-	for(int line_idx = 0; line_idx < lines.size(); line_idx++)
+	CommentState comments;
+	string line;
+
+	for(ccp line_start = start, line_end;; line_start = line_end + 1)
 	{
+		line_end = (ccp)memchr(line_start, '\n', end - line_start);
+		if(!line_end) line_end = end;
 		_current_line_no++;
 
-		_current_original_line = lines[line_idx];
-		string line_str = strip_start(lines[line_idx]);
-		
-		if(line_str[0] == '#') // handle directives
-			handle_directive(strip_start(line_str.erase(0, 1)), _current_line_no);
-		else if(IN_FALSE_BRANCH)
-			SUBMIT_LINE("");
-		
-		else SUBMIT_LINE(handle_plain_line(lines[line_idx]));
+		// lines without any comments, strings, directives or macros are copied straight from the source
+		ccp c = simd::find_line_special(line_start, line_end);
+
+		if(c == line_end && !comments.in_block_comment && !comments.in_string && !comments.in_character)
+		{
+			if(IN_FALSE_BRANCH) submit_line(line_start, 0);
+			else submit_line(line_start, line_end - line_start);
+		}
+		else
+		{
+			line.assign(line_start, line_end - line_start);
+			remove_comments(line, &comments);
+
+			_current_original_line = line;
+			string line_str = strip_start(line);
+			
+			if(line_str[0] == '#') // handle directives
+				handle_directive(strip_start(line_str.erase(0, 1)), _current_line_no);
+			else if(IN_FALSE_BRANCH)
+				SUBMIT_LINE("");
+			
+			else SUBMIT_LINE(handle_plain_line(line));
+		}
+
+		if(line_end == end) break;
 	}
 
 	if(_branches->size()) error_at_line(_current_line_no, "Expected #endif.", "");
 }
 
+void Preprocessor::submit_line(ccp line, size_t length)
+{
+	// room for the newline and the final terminator
+	if(_output_length + length + 2 > _output_capacity)
+	{
+		_output_capacity = max(_output_capacity * 2, _output_length + length + 2);
+		_output = (char*)realloc(_output, _output_capacity);
+	}
+
+	memcpy(_output + _output_length, line, length);
+	_output_length += length;
+	_output[_output_length++] = '\n';
+}
+
+void Preprocessor::submit_line(string line)
+{
+	submit_line(line.c_str(), line.length());
+}
+
 string Preprocessor::handle_plain_line(string line)
 {
-	cmatch match; // index 0 is whole match
-	regex regexp(MACRO_INVOKE_REGEX);
+	// most lines don't invoke any macros at all
+	if(line.find('#') == string::npos) return line;
+
+	string expanded;
+	expanded.reserve(line.length());
+	if(!expand_macros(line.c_str(), line.c_str() + line.length(), &expanded, line, 0)) return line;
+	return expanded;
+}
+
+// expands each 'name#' in [start, end) into dest, expanding
+// the macro bodies themselves too. returns false on error.
+bool Preprocessor::expand_macros(ccp start, ccp end, string* dest, string& line, uint depth)
+{
+	#define IS_IDENT_CHAR(c) (isalnum(c) || (c) == '_')
 
-	while(regex_search(line.c_str(), match, regexp))
+	if(depth > MAX_MACRO_EXPANSION_DEPTH)
 	{
-		string macro = match[1].str();
+		ERROR_F(_current_line_no, line, "Macro expansion depth surpassed limit of %d.", MAX_MACRO_EXPANSION_DEPTH);
+		return false;
+	}
+
+	ccp copied = start; // everything before this is already in dest
+	for(ccp c = start; c < end; c++)
+	{
+		if(*c != '#') continue;
+
+		// find the identifier right before the '#'
+		ccp name = c;
+		while(name > copied && IS_IDENT_CHAR(name[-1])) name--;
+		while(name < c && isdigit(*name)) name++;
+		if(name == c) continue;
 
 		// check if macro exists
-		if(!CHECK_MACRO(macro))
+		_macro_name.assign(name, c - name);
+		auto macro = _macros->find(_macro_name);
+		if(macro == _macros->end())
 		{
-			Token tok = generate_token(line, macro + '#');
-			ccp msg = strdup(tools::fstr("Macro '%s' is not defined.", macro.c_str()).c_str());
+			ccp msg = strdup(tools::fstr("Macro '%s' is not defined.", _macro_name.c_str()).c_str());
 
-			_error_dispatcher.error_at_token(&tok, "Preprocessing Error", msg);
-			cerr << endl;
-			_error_dispatcher.print_token_marked(&tok, COLOR_RED);
-
-			_had_error = true;
-			return line;
+			// the invocation might come from another macro's body
+			if(depth) ERROR(_current_line_no, line, msg)
+			else
+			{
+				Token tok = generate_token(line, _macro_name + '#');
+				error_at_token(&tok, msg);
+			}
+			return false;
 		}
 
-		// get macro properties
-		MacroProperties props = _macros->at(macro);
-		string format = props.has_getter ? (props.getter)() : props.format;
+		dest->append(copied, name - copied);
+		copied = c + 1;
 
-		// replace 
-		line = regex_replace(line, regexp, format);
+		// expand the macro's body in place
+		if(macro->second.has_getter)
+		{
+			string format = (macro->second.getter)();
+			if(!expand_macros(format.c_str(), format.c_str() + format.length(), dest, line, depth + 1)) return false;
+		}
+		else
+		{
+			string& format = macro->second.format;
+			if(!expand_macros(format.c_str(), format.c_str() + format.length(), dest, line, depth + 1)) return false;
+		}
 	}
-	return line;
+
+	dest->append(copied, end - copied);
+	return true;
+	#undef IS_IDENT_CHAR
 }
 
-vector<string> Preprocessor::remove_comments(vector<string> lines)
+// blanks out the comments in line. the state is carried over
+// to the next line for block comments, strings and characters.
+void Preprocessor::remove_comments(string& line, CommentState* state)
 {
-	bool in_block_comment = false;
-	bool in_string = false;
-	bool in_character = false;
-
-	for(auto& line : lines)
+	for(int i = 0; i < line.length(); i++)
 	{
-		for(int i = 0; i < line.length(); i++)
+		if(state->in_block_comment)
 		{
-			if(in_block_comment)
-			{
-				if(i + 1 < line.length() && line[i] == ':' && line[i + 1] == '\\')
-				{
-					in_block_comment = false;
-					line[i] = ' ';
-					line[++i] = ' ';
-				}
-				else line[i] = ' ';
-			}
-			else if(in_string)
-			{
-				// check for end of string
-				if(line[i] == '"' && line[i - 1] != '\\') in_string = false;
-			}
-			else if(in_character)
+			if(i + 1 < line.length() && line[i] == ':' && line[i + 1] == '\\')
 			{
-				// check for end of character
-				if(line[i] == '\'' && line[i - 1] != '\\') in_character = false;
-			}
-			else if(i + 1 < line.length() && line[i] == '\\' && line[i + 1] == ':') // start block comment
-			{
-				in_block_comment = true;
+				state->in_block_comment = false;
 				line[i] = ' ';
 				line[++i] = ' ';
 			}
-			else if(line[i] == '\\')  // line comment
-			{
-				// just rest with whitespaces
-				while(i < line.length()) line[i++] = ' ';
-			}
-			else if(line[i] == '"') in_string = true; // start string 
-			else if(line[i] == '\'') in_character = true; // start char 
+			else line[i] = ' ';
 		}
+		else if(state->in_string)
+		{
+			// check for end of string
+			if(line[i] == '"' && (i == 0 || line[i - 1] != '\\')) state->in_string = false;
+		}
+		else if(state->in_character)
+		{
+			// check for end of character
+			if(line[i] == '\'' && (i == 0 || line[i - 1] != '\\')) state->in_character = false;
+		}
+		else if(i + 1 < line.length() && line[i] == '\\' && line[i + 1] == ':') // start block comment
+		{
+			state->in_block_comment = true;
+			line[i] = ' ';
+			line[++i] = ' ';
+		}
+		else if(line[i] == '\\')  // line comment
+		{
+			// just rest with whitespaces
+			while(i < line.length()) line[i++] = ' ';
+		}
+		else if(line[i] == '"') state->in_string = true; // start string 
+		else if(line[i] == '\'') state->in_character = true; // start char 
 	}
-
-	return lines;
 }
 
 // ===============================================================
@@ -230,6 +308,7 @@ Token Preprocessor::generate_token(string line, string token)
 	ccp src = strdup(line.c_str());
 	return Token{
 		TOKEN_ERROR,
+		0,
 		src,
 		src + offset,
 		(int)token.length(),
@@ -530,16 +609,17 @@ HANDLER(apply)
 	}
 	
 	// DEBUG_PRINT_F_MSG("Found header '%s' at '%s'.", header.c_str(), path.c_str());
-	string source = tools::readf(path);
+	TIME_TRACE_SCOPE("apply", path);
+	size_t size;
+	ccp source = tools::mapf(path, &size);
 
 	_current_file = path;
 	_current_line_no = 0;
 
 	// process text
-	vector<string> lines = tools::split_string(source, "\n");
-	lines = remove_comments(lines);
 	LINE_MARKER(0);
-	process_lines(lines);
+	process_lines(source, source + size);
+	tools::unmapf(source, size);
 
 	// continue current file
 	_current_file = oldfile;
@@ -1,20 +1,71 @@
 #include "common.hpp"
 #include "scanner.hpp"
 #include "tools.hpp"
+#include "simd.hpp"
 
 #include <cstdio>
 #include <cctype>
 #include <cstring>
-#include <regex>
+
+thread_local FileTable* __files = nullptr;
+
+string* FileTable::intern(const char *name, size_t length)
+{
+	// consecutive lookups mostly name the same file
+	if(_last && _last->length() == length && !memcmp(_last->data(), name, length)) return _last;
+
+	for(string& existing : _names)
+		if(existing.length() == length && !memcmp(existing.data(), name, length)) return _last = &existing;
+
+	_names.emplace_back(name, length);
+	return _last = &_names.back();
+}
+
+void SourceMap::add_run(size_t offset, const string& file, uint line)
+{
+	uint32_t id = 0;
+	while(id < _files.size() && _files[id] != file) id++;
+	if(id == _files.size()) _files.push_back(file);
+
+	// a run without any lines is replaced right away
+	if(_runs.size() && _runs.back().offset == offset) _runs.pop_back();
+	_runs.push_back({(uint32_t)offset, id, line});
+}
+
+string SourceMap::insert_markers(const char *output) const
+{
+	string annotated;
+	const char *copied = output;
+
+	for(const SourceRun& run : _runs)
+	{
+		annotated.append(copied, output + run.offset - copied);
+		annotated += tools::fstr("# %d \"%s\"\n", run.line - 1, _files[run.file].c_str());
+		copied = output + run.offset;
+	}
+
+	annotated += copied;
+	return annotated;
+}
+
+// =========================
 
 Scanner::Scanner() {}
 
-Scanner::Scanner(const char *source)
+Scanner::Scanner(const char *source, const SourceMap* map)
 {
 	_src_start = source;
 	_start = source;
 	_current = source;
 	_line = 1;
+	_filename = nullptr;
+	_lines = make_unique<LineIndex>();
+
+	_map = map;
+	_next_run = 0;
+	if(map) for(const std::string& file : map->get_files())
+		_map_files.push_back(__files->intern(file.c_str(), file.length()));
+	enterRuns(0);
 }
 
 int Scanner::getScannedLength()
@@ -23,6 +74,12 @@ int Scanner::getScannedLength()
 	return (int)(_current - _src_start);
 }
 
+unique_ptr<LineIndex> Scanner::takeLineIndex()
+{
+	//
+	return move(_lines);
+}
+
 bool Scanner::isAtEnd()
 {
 	//
@@ -75,11 +132,14 @@ Token Scanner::makeToken(TokenType type)
 {
 	return Token{
 		/*type*/ type,
+		/*index*/ 0,
 		/*source*/ _src_start,
 		/*start*/ _start,
 		/*length*/ (int)(_current - _start),
 		/*line*/ _line,
 		/*file*/ _filename,
+		/*lines*/ _lines.get(),
+		/*evi_type*/ nullptr,
 	};
 }
 
@@ -87,30 +147,43 @@ Token Scanner::errorToken(const char *message)
 {
 	return Token{
 		/*type*/ TOKEN_ERROR,
+		/*index*/ 0,
 		/*source*/ _src_start,
 		/*start*/ message,
 		/*length*/ (int)strlen(message),
 		/*line*/ _line,
-		/*file*/ _filename
+		/*file*/ _filename,
+		/*lines*/ _lines.get()
 	};
 }
 
 Token Scanner::string()
 {
-	while (peek() != '"' && !isAtEnd())
+	for (;;)
 	{
-		if (peek() == '\n')
-			_line++;
-		else if (peek() == '\\')
-			advance();
-		advance();
-	}
+		// skip to the next '"', '\\', newline or the end
+		_current = simd::find_string_special(_current);
 
-	if (isAtEnd()) return errorToken("Unterminated string.");
+		switch (peek())
+		{
+		case '"':
+			// The closing quote.
+			advance();
+			return makeToken(TOKEN_STRING);
+		case '\\':
+			advance();
+			if (isAtEnd()) break;
+			if (peek() == '\n') newLine();
+			advance();
+			continue;
+		case '\n':
+			newLine();
+			advance();
+			continue;
+		}
 
-	// The closing quote.
-	advance();
-	return makeToken(TOKEN_STRING);
+		return errorToken("Unterminated string.");
+	}
 }
 
 Token Scanner::character()
@@ -170,12 +243,16 @@ Token Scanner::number()
 
 Token Scanner::type_or_identifier()
 {
-	while (isAlpha(peek()) || isDigit(peek()))
-		advance();
+	_current = simd::skip_identifier(_current);
 	
-	// check if token is identifier
-	std::string token = std::string(_start, _current - _start);
-	if(IS_EVI_TYPE(token)) return makeToken(TOKEN_TYPE);
+	// check if token is a type
+	BuiltinType builtin = find_builtin_type(_start, _current - _start);
+	if(builtin != BUILTIN_NONE)
+	{
+		Token token = makeToken(TOKEN_TYPE);
+		token.evi_type = GET_BUILTIN_EVI_TYPE(builtin);
+		return token;
+	}
 
 	return makeToken(TOKEN_IDENTIFIER);
 }
@@ -185,8 +262,7 @@ Token Scanner::reference()
 	if(isAlpha(peek()))
 	{
 		// variable
-		advance();
-		while (isAlpha(peek()) || isDigit(peek())) advance();
+		_current = simd::skip_identifier(_current + 1);
 		return makeToken(TOKEN_VARIABLE_REF);
 	}
 	else if(isDigit(peek()))
@@ -199,40 +275,6 @@ Token Scanner::reference()
 	else return errorToken("Expected identifier or integer.");
 }
 
-Token Scanner::directive()
-{
-	// get line
-	// ptrdiff_t start = (ptrdiff_t)_start;
-	while(peek() != '\n' && !isAtEnd()) advance();
-	std::string line = std::string(_start + 1, _current);
-
-	// check it
-	cmatch match; // index 0 is whole match
-	if(regex_match(line.c_str(), match, regex(LINE_MARKER_REGEX)))
-	{
-		// marker
-		// get lineno and filename
-		int lineno = stoi(match[1].str(), 0, 10);
-		_line = lineno;
-		_filename = new std::string(match[2].str());
-
-		// // clear line marker for neatness' sake
-		// std::string new_line = std::string(' ', line.length() + 1);
-		// _src_start[start] = ' '; // remove '\0'
-
-		// return token
-		return Token{
-			/*type  */ TOKEN_LINE_MARKER,
-			/*source */ _src_start,
-			/*start */ 0,
-			/*length*/ 0,
-			/*line  */ lineno,
-			/*file  */ _filename,
-		};
-	}
-	else return errorToken("Preprocessed code corrupted. (Line or flag marker invalid.)");
-}
-
 void Scanner::skipWhitespaces()
 {
 	for (;;)
@@ -243,10 +285,13 @@ void Scanner::skipWhitespaces()
 		case ' ':
 		case '\r':
 		case '\t':
+			// single blanks between tokens aren't worth a kernel call
 			advance();
+			if (peek() == ' ' || peek() == '\t' || peek() == '\r')
+				_current = simd::skip_blanks(_current);
 			break;
 		case '\n':
-			_line++;
+			newLine();
 			advance();
 			break;
 		// case '\\':
@@ -277,6 +322,29 @@ void Scanner::skipWhitespaces()
 	}
 }
 
+// called on each newline before it is consumed
+void Scanner::newLine()
+{
+	_line++;
+	_lines->add_line(_current - _src_start + 1);
+
+	// the next line might start a new run
+	enterRuns(_current - _src_start + 1);
+}
+
+// takes the file and line from the source map if a run starts at offset
+void Scanner::enterRuns(ptrdiff_t offset)
+{
+	if(!_map) return;
+
+	const vector<SourceRun>& runs = _map->get_runs();
+	for(; _next_run < runs.size() && runs[_next_run].offset <= offset; _next_run++)
+	{
+		_filename = _map_files[runs[_next_run].file];
+		_line = runs[_next_run].line;
+	}
+}
+
 Token Scanner::scanToken()
 {
 	skipWhitespaces();
@@ -335,8 +403,6 @@ Token Scanner::scanToken()
 		case '$': return reference();
 		case '"': return string();
 		case '\'': return character();
-
-		case '#': return directive();
 	}
 
 	char* errstr = new char[25]; // just above what's needed
@@ -347,6 +413,79 @@ Token Scanner::scanToken()
 
 // =========================
 
+TokenBuffer::TokenBuffer(const char *source, const SourceMap* map)
+{
+	_source = source;
+
+	Scanner scanner(source, map);
+
+	// roughly one token per four bytes of source
+	size_t expected = strlen(source) / 4;
+	_types.reserve(expected);
+	_offsets.reserve(expected);
+	_lengths.reserve(expected);
+	_linenos.reserve(expected);
+	_files.reserve(expected);
+
+	Token token;
+	do {
+		token = scanner.scanToken();
+		push(token);
+	} while(token.type != TOKEN_EOF);
+
+	// the tokens handed out by get() point into it
+	_lines = scanner.takeLineIndex();
+}
+
+void TokenBuffer::push(Token token)
+{
+	// a new file table entry is only needed after a line marker
+	if(_filetable.empty() || _filetable.back() != token.file)
+		_filetable.push_back(token.file);
+
+	uint32_t offset;
+	if(token.type == TOKEN_ERROR)
+	{
+		offset = _messages.size();
+		_messages.push_back(token.start);
+	}
+	else offset = (uint32_t)(token.start - _source);
+
+	_types.push_back(token.type);
+	_offsets.push_back(offset);
+	_lengths.push_back(token.type == TOKEN_TYPE ? find_builtin_type(token.start, token.length) : token.length);
+	_linenos.push_back(token.line);
+	_files.push_back(_filetable.size() - 1);
+}
+
+Token TokenBuffer::get(size_t index) const
+{
+	if(index >= _types.size()) index = _types.size() - 1;
+
+	TokenType type = (TokenType)_types[index];
+	Token token = Token{
+		/*type*/ type,
+		/*index*/ (uint32_t)index,
+		/*source*/ _source,
+		/*start*/ type == TOKEN_ERROR ? _messages[_offsets[index]] : _source + _offsets[index],
+		/*length*/ (int)_lengths[index],
+		/*line*/ (int)_linenos[index],
+		/*file*/ _filetable[_files[index]],
+		/*lines*/ _lines.get(),
+		/*evi_type*/ nullptr,
+	};
+
+	if(type == TOKEN_TYPE)
+	{
+		BuiltinType builtin = (BuiltinType)_lengths[index];
+		token.length = strlen(builtin_type_names[builtin]);
+		token.evi_type = GET_BUILTIN_EVI_TYPE(builtin);
+	}
+	return token;
+}
+
+// =========================
+
 char *get_tokentype_str(TokenType type)
 {
 	switch(type)
@@ -410,7 +549,6 @@ char *get_tokentype_str(TokenType type)
 		case TOKEN_TYPE: return "TYPE";
 
 		// misc.
-		case TOKEN_LINE_MARKER: return "LINE_MARKER";
 		case TOKEN_ERROR: return "ERROR";
 		case TOKEN_EOF: return "EOF";
 	}
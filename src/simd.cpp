@@ -0,0 +1,176 @@
+#include "simd.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+// ====================== scalar =======================
+
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r')
+#define IS_IDENT(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || ((c) >= '0' && (c) <= '9') || (c) == '_')
+#define IS_STRING_SPECIAL(c) ((c) == '"' || (c) == '\\' || (c) == '\n' || (c) == '\0')
+#define IS_LINE_SPECIAL(c) ((c) == '\\' || (c) == '#' || (c) == '"' || (c) == '\'')
+
+static ccp skip_blanks_scalar(ccp str)
+{
+	while(IS_BLANK(*str)) str++;
+	return str;
+}
+
+static ccp skip_identifier_scalar(ccp str)
+{
+	while(IS_IDENT(*str)) str++;
+	return str;
+}
+
+static ccp find_string_special_scalar(ccp str)
+{
+	while(!IS_STRING_SPECIAL(*str)) str++;
+	return str;
+}
+
+static ccp find_line_special_scalar(ccp str, ccp end)
+{
+	while(str < end && !IS_LINE_SPECIAL(*str)) str++;
+	return str;
+}
+
+// ======================== x86 ========================
+
+#ifdef SIMD_X86
+
+// a null-terminated kernel. MASK gives the bits of the chars to stop at
+// in an aligned block, the terminator included, so the loop always ends.
+#define DEFINE_TERMINATED_KERNEL(NAME, MASK, WIDTH, ATTR) \
+	ATTR static ccp NAME(ccp str) \
+	{ \
+		uintptr_t offset = (uintptr_t)str % WIDTH; \
+		ccp block = str - offset; \
+		uint32_t mask = MASK(block) >> offset; \
+		if(mask) return str + __builtin_ctz(mask); \
+		for(;;) \
+		{ \
+			block += WIDTH; \
+			if((mask = MASK(block))) return block + __builtin_ctz(mask); \
+		} \
+	}
+
+// a kernel over [str, end). aligned blocks that start before end don't cross
+// into another page, so the bytes after end can be read and masked off.
+#define DEFINE_RANGE_KERNEL(NAME, MASK, WIDTH, ATTR) \
+	ATTR static ccp NAME(ccp str, ccp end) \
+	{ \
+		if(str >= end) return end; \
+		uintptr_t offset = (uintptr_t)str % WIDTH; \
+		ccp block = str - offset; \
+		uint32_t mask = MASK(block) >> offset << offset; \
+		for(;;) \
+		{ \
+			if(mask) return block + __builtin_ctz(mask) < end ? block + __builtin_ctz(mask) : end; \
+			block += WIDTH; \
+			if(block >= end) return end; \
+			mask = MASK(block); \
+		} \
+	}
+
+// defines the masks and kernels of one instruction set. PRE and SUF select
+// the intrinsics (_mm and si128 or _mm256 and si256) and ATTR is put on every
+// function, so that avx2 code is only generated where it is asked for.
+#define DEFINE_KERNELS(ISA, VEC, WIDTH, PRE, SUF, ATTR) \
+	ATTR static inline VEC eq_##ISA(VEC v, char c) { return PRE##_cmpeq_epi8(v, PRE##_set1_epi8(c)); } \
+	ATTR static inline VEC or_##ISA(VEC a, VEC b) { return PRE##_or_##SUF(a, b); } \
+	ATTR static inline VEC in_range_##ISA(VEC v, char lo, char hi) \
+	{ \
+		/* signed compares, but everything above 0x7f is negative and out of range anyway */ \
+		return PRE##_and_##SUF(PRE##_cmpgt_epi8(v, PRE##_set1_epi8(lo - 1)), PRE##_cmpgt_epi8(PRE##_set1_epi8(hi + 1), v)); \
+	} \
+	ATTR static inline uint32_t bits_##ISA(VEC v) { return (uint32_t)PRE##_movemask_epi8(v); } \
+	ATTR static inline VEC load_##ISA(ccp block) { return PRE##_load_##SUF((const VEC*)block); } \
+	\
+	ATTR static inline uint32_t blanks_mask_##ISA(ccp block) \
+	{ \
+		VEC v = load_##ISA(block); \
+		VEC blank = or_##ISA(or_##ISA(eq_##ISA(v, ' '), eq_##ISA(v, '\t')), eq_##ISA(v, '\r')); \
+		return ~bits_##ISA(blank) & (uint32_t)(((uint64_t)1 << WIDTH) - 1); \
+	} \
+	ATTR static inline uint32_t identifier_mask_##ISA(ccp block) \
+	{ \
+		VEC v = load_##ISA(block); \
+		VEC lower = PRE##_or_##SUF(v, PRE##_set1_epi8(0x20)); \
+		VEC ident = or_##ISA(or_##ISA(in_range_##ISA(lower, 'a', 'z'), in_range_##ISA(v, '0', '9')), eq_##ISA(v, '_')); \
+		return ~bits_##ISA(ident) & (uint32_t)(((uint64_t)1 << WIDTH) - 1); \
+	} \
+	ATTR static inline uint32_t string_mask_##ISA(ccp block) \
+	{ \
+		VEC v = load_##ISA(block); \
+		return bits_##ISA(or_##ISA(or_##ISA(eq_##ISA(v, '"'), eq_##ISA(v, '\\')), or_##ISA(eq_##ISA(v, '\n'), eq_##ISA(v, '\0')))); \
+	} \
+	ATTR static inline uint32_t line_mask_##ISA(ccp block) \
+	{ \
+		VEC v = load_##ISA(block); \
+		return bits_##ISA(or_##ISA(or_##ISA(eq_##ISA(v, '\\'), eq_##ISA(v, '#')), or_##ISA(eq_##ISA(v, '"'), eq_##ISA(v, '\'')))); \
+	} \
+	\
+	DEFINE_TERMINATED_KERNEL(skip_blanks_##ISA, blanks_mask_##ISA, WIDTH, ATTR) \
+	DEFINE_TERMINATED_KERNEL(skip_identifier_##ISA, identifier_mask_##ISA, WIDTH, ATTR) \
+	DEFINE_TERMINATED_KERNEL(find_string_special_##ISA, string_mask_##ISA, WIDTH, ATTR) \
+	DEFINE_RANGE_KERNEL(find_line_special_##ISA, line_mask_##ISA, WIDTH, ATTR)
+
+// sse2 is part of every x86-64 cpu
+DEFINE_KERNELS(sse2, __m128i, 16, _mm, si128, __attribute__((target("sse2"))))
+DEFINE_KERNELS(avx2, __m256i, 32, _mm256, si256, __attribute__((target("avx2"))))
+
+#endif
+
+// ===================== dispatch ======================
+
+typedef struct
+{
+	ccp (*skip_blanks)(ccp);
+	ccp (*skip_identifier)(ccp);
+	ccp (*find_string_special)(ccp);
+	ccp (*find_line_special)(ccp, ccp);
+	ccp isa;
+} Kernels;
+
+#define KERNELS(isa) Kernels{ skip_blanks_##isa, skip_identifier_##isa, find_string_special_##isa, find_line_special_##isa, #isa }
+
+// the best variant the cpu supports, unless $EVI_SIMD asks for a lesser one.
+// unknown values are warned about and ignored
+static Kernels select_kernels()
+{
+	ccp wanted = getenv(SIMD_ENV);
+	if(wanted && !*wanted) wanted = nullptr;
+	if(wanted && strcmp(wanted, "scalar") && strcmp(wanted, "sse2") && strcmp(wanted, "avx2"))
+	{
+		// cerr might not be constructed yet this early
+		fprintf(stderr, "[evi] Warning: Ignoring invalid " SIMD_ENV " value '%s'.\n", wanted);
+		fprintf(stderr, "[evi] Note: Valid values: 'scalar', 'sse2', 'avx2'\n");
+		wanted = nullptr;
+	}
+	#define ALLOWED(isa) (!wanted || !strcmp(wanted, #isa))
+
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2") && ALLOWED(avx2)) return KERNELS(avx2);
+	if(__builtin_cpu_supports("sse2") && (ALLOWED(sse2) || ALLOWED(avx2))) return KERNELS(sse2);
+#endif
+	return KERNELS(scalar);
+
+	#undef ALLOWED
+}
+
+// selected before main() runs, so the scanner threads never race on it
+static const Kernels __kernels = select_kernels();
+
+ccp simd::skip_blanks(ccp str) { return __kernels.skip_blanks(str); }
+ccp simd::skip_identifier(ccp str) { return __kernels.skip_identifier(str); }
+ccp simd::find_string_special(ccp str) { return __kernels.find_string_special(str); }
+ccp simd::find_line_special(ccp str, ccp end) { return __kernels.find_line_special(str, end); }
+ccp simd::get_isa() { return __kernels.isa; }
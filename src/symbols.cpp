@@ -0,0 +1,137 @@
+#include "symbols.hpp"
+
+#define SYMBOLS_INITIAL_SLOTS 256 // power of two
+
+static size_t hash_identifier(string& name)
+{
+	// fnv-1a
+	size_t hash = 14695981039346656037ULL;
+	for(char c : name) hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+	return hash;
+}
+
+SymbolTable::SymbolTable()
+{
+	_slots = vector<Identifier*>(SYMBOLS_INITIAL_SLOTS, nullptr);
+}
+
+SymbolTable::Identifier* SymbolTable::intern(string& name, bool insert)
+{
+	size_t hash = hash_identifier(name);
+	size_t mask = _slots.size() - 1;
+
+	// linear probing, identifiers are never removed
+	for(size_t i = hash & mask;; i = (i + 1) & mask)
+	{
+		Identifier* identifier = _slots[i];
+		if(!identifier)
+		{
+			if(!insert) return nullptr;
+
+			_identifiers.push_back({name, hash, nullptr, nullptr});
+			_slots[i] = &_identifiers.back();
+
+			// keep the load factor below a half
+			if(_identifiers.size() * 2 > _slots.size()) grow();
+			return &_identifiers.back();
+		}
+		if(identifier->hash == hash && identifier->name == name) return identifier;
+	}
+}
+
+void SymbolTable::grow()
+{
+	_slots = vector<Identifier*>(_slots.size() * 2, nullptr);
+	size_t mask = _slots.size() - 1;
+
+	for(Identifier& identifier : _identifiers)
+	{
+		size_t i = identifier.hash & mask;
+		while(_slots[i]) i = (i + 1) & mask;
+		_slots[i] = &identifier;
+	}
+}
+
+VarProperties* SymbolTable::get_variable(string name)
+{
+	Identifier* identifier = intern(name, false);
+	return identifier ? identifier->variable : nullptr;
+}
+
+FuncProperties* SymbolTable::get_function(string name)
+{
+	Identifier* identifier = intern(name, false);
+	return identifier ? identifier->function : nullptr;
+}
+
+VarProperties* SymbolTable::add_variable(string name, VarProperties properties)
+{
+	Identifier* identifier = intern(name, true);
+	_log.push_back({identifier, identifier->variable, nullptr, false});
+	_variables.push_back(properties);
+	return identifier->variable = &_variables.back();
+}
+
+FuncProperties* SymbolTable::add_function(string name, FuncProperties properties)
+{
+	Identifier* identifier = intern(name, true);
+	_log.push_back({identifier, nullptr, identifier->function, true});
+	_functions.push_back(properties);
+	return identifier->function = &_functions.back();
+}
+
+void SymbolTable::scope_up()
+{
+	_scope_starts.push_back(_log.size());
+}
+
+void SymbolTable::scope_down()
+{
+	ASSERT_OR_THROW_INTERNAL_ERROR(!_scope_starts.empty(), "during scope exit");
+	size_t start = _scope_starts.back();
+	_scope_starts.pop_back();
+
+	while(_log.size() > start)
+	{
+		Declaration& decl = _log.back();
+		if(decl.is_function)
+		{
+			decl.identifier->function = decl.function;
+			_functions.pop_back();
+		}
+		else
+		{
+			decl.identifier->variable = decl.variable;
+			_variables.pop_back();
+		}
+		_log.pop_back();
+	}
+}
+
+int SymbolTable::depth()
+{
+	return _scope_starts.size();
+}
+
+vector<pair<string, VarProperties*>> SymbolTable::get_variables()
+{
+	vector<pair<string, VarProperties*>> variables;
+	for(auto decl = _log.rbegin(); decl != _log.rend(); decl++)
+		if(!decl->is_function) variables.push_back({decl->identifier->name, nullptr});
+
+	// the storage is in declaration order as well
+	auto variable = _variables.rbegin();
+	for(auto& entry : variables) entry.second = &*variable++;
+	return variables;
+}
+
+vector<pair<string, FuncProperties*>> SymbolTable::get_functions()
+{
+	vector<pair<string, FuncProperties*>> functions;
+	for(auto decl = _log.rbegin(); decl != _log.rend(); decl++)
+		if(decl->is_function) functions.push_back({decl->identifier->name, nullptr});
+
+	auto function = _functions.rbegin();
+	for(auto& entry : functions) entry.second = &*function++;
+	return functions;
+}
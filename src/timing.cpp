@@ -0,0 +1,196 @@
+#include "timing.hpp"
+#include "error.hpp"
+#include "simd.hpp"
+#include <sys/resource.h>
+#include <chrono>
+#include <mutex>
+
+timing_args_t timing_args = { false, false, nullptr };
+
+typedef struct
+{
+	ccp phase;
+	string file;
+	double wall_ms;
+	double cpu_ms;
+	// of the whole process when the phase ended. phases of other files
+	// run at the same time, so this isn't what the phase itself used
+	long max_rss_so_far_kb;
+	long units;
+	ccp unit;
+} PhaseTiming;
+
+static vector<PhaseTiming> phase_timings;
+static mutex phase_timings_mutex;
+
+// ================================
+
+static double get_wall_ms()
+{
+	auto now = chrono::steady_clock::now().time_since_epoch();
+	return chrono::duration<double, milli>(now).count();
+}
+
+// cpu time of the calling thread only, as phases of
+// different files might run at the same time
+static double get_cpu_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// peak resident set size of the whole process so far
+static long get_peak_rss_kb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+// ================================
+
+PhaseTimer::PhaseTimer(ccp phase, string file)
+{
+	_phase = phase;
+	_file = file;
+	_running = true;
+	_units = 0;
+	_unit = nullptr;
+	_wall_start = get_wall_ms();
+	_cpu_start = get_cpu_ms();
+
+	if(llvm::timeTraceProfilerEnabled()) llvm::timeTraceProfilerBegin(_phase, _file);
+}
+
+void PhaseTimer::stop()
+{
+	if(!_running) return;
+	_running = false;
+
+	if(llvm::timeTraceProfilerEnabled()) llvm::timeTraceProfilerEnd();
+	if(!timing_args.time_phases) return;
+
+	PhaseTiming timing = {
+		_phase, _file,
+		get_wall_ms() - _wall_start,
+		get_cpu_ms() - _cpu_start,
+		get_peak_rss_kb(),
+		_units, _unit
+	};
+
+	lock_guard<mutex> lock(phase_timings_mutex);
+	phase_timings.push_back(timing);
+}
+
+// ================================
+
+void timing_initialize_thread()
+{
+	if(timing_args.trace_file)
+		llvm::timeTraceProfilerInitialize(TIME_TRACE_GRANULARITY, APP_NAME);
+}
+
+void timing_finish_thread()
+{
+	if(timing_args.trace_file)
+		llvm::timeTraceProfilerFinishThread();
+}
+
+void timing_register_pass_callbacks(llvm::PassInstrumentationCallbacks* callbacks)
+{
+	if(!timing_args.trace_file) return;
+
+	callbacks->registerBeforeNonSkippedPassCallback([](llvm::StringRef pass, llvm::Any) {
+		llvm::timeTraceProfilerBegin("llvm pass", pass);
+	});
+	callbacks->registerAfterPassCallback([](llvm::StringRef, llvm::Any, const llvm::PreservedAnalyses&) {
+		llvm::timeTraceProfilerEnd();
+	});
+	callbacks->registerAfterPassInvalidatedCallback([](llvm::StringRef, const llvm::PreservedAnalyses&) {
+		llvm::timeTraceProfilerEnd();
+	});
+}
+
+static string get_throughput(PhaseTiming* timing)
+{
+	if(!timing->unit) return "";
+	double per_sec = timing->wall_ms > 0 ? timing->units / (timing->wall_ms / 1e3) : 0;
+	return tools::fstr("%.0f %s/s", per_sec, timing->unit);
+}
+
+static void print_phase_timings()
+{
+	cerr << "[evi] Phase timings:" << endl;
+	cerr << tools::fstr("  %-12s %12s %12s %24s %22s  %s", "phase", "wall (ms)",
+						"cpu (ms)", "max rss so far (KiB)", "throughput", "file") << endl;
+
+	double total_wall = 0, total_cpu = 0;
+	for(PhaseTiming& timing : phase_timings)
+	{
+		cerr << tools::fstr("  %-12s %12.3f %12.3f %24ld %22s  %s", timing.phase, timing.wall_ms, timing.cpu_ms,
+							timing.max_rss_so_far_kb, get_throughput(&timing).c_str(), timing.file.c_str()) << endl;
+		total_wall += timing.wall_ms;
+		total_cpu += timing.cpu_ms;
+	}
+
+	cerr << tools::fstr("  %-12s %12.3f %12.3f %24ld", "total", total_wall,
+						total_cpu, get_peak_rss_kb()) << endl;
+}
+
+// escapes a string for use in a json string literal
+static string json_escape(string str)
+{
+	string escaped;
+	for(unsigned char c : str) switch(c)
+	{
+		case '"': escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\b': escaped += "\\b"; break;
+		case '\f': escaped += "\\f"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\r': escaped += "\\r"; break;
+		case '\t': escaped += "\\t"; break;
+		default:
+			if(c < 0x20) escaped += tools::fstr("\\u%04x", c);
+			else escaped += c;
+	}
+	return escaped;
+}
+
+// machine-readable version for benchmarks and such
+static void print_phase_timings_json()
+{
+	cout << "{\"phases\": [";
+	for(size_t i = 0; i < phase_timings.size(); i++)
+	{
+		PhaseTiming& timing = phase_timings[i];
+		cout << tools::fstr("%s{\"phase\": \"%s\", \"file\": \"%s\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"max_rss_so_far_kb\": %ld",
+							i ? ", " : "", timing.phase, json_escape(timing.file).c_str(), timing.wall_ms,
+							timing.cpu_ms, timing.max_rss_so_far_kb);
+		if(timing.unit) cout << tools::fstr(", \"units\": %ld, \"unit\": \"%s\"", timing.units, timing.unit);
+		cout << "}";
+	}
+	cout << tools::fstr("], \"peak_rss_kb\": %ld, \"simd\": \"%s\"}", get_peak_rss_kb(), simd::get_isa()) << endl;
+}
+
+Status timing_report()
+{
+	if(timing_args.time_phases && timing_args.json) print_phase_timings_json();
+	else if(timing_args.time_phases) print_phase_timings();
+
+	if(timing_args.trace_file)
+	{
+		llvm::Error error = llvm::timeTraceProfilerWrite(timing_args.trace_file, APP_NAME);
+		llvm::timeTraceProfilerCleanup();
+
+		if(error)
+		{
+			ErrorDispatcher().error("Output Error", tools::fstr("Could not write time trace to \"%s\": %s.",
+				timing_args.trace_file, llvm::toString(move(error)).c_str()).c_str());
+			return STATUS_OUTPUT_ERROR;
+		}
+	}
+
+	return STATUS_SUCCESS;
+}
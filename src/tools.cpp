@@ -11,7 +11,10 @@
 
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 
 using namespace std;
@@ -202,6 +205,48 @@ string tools::readf(string path)
     return buffer;
 }
 
+// map file read-only into memory, followed by a null terminator
+const char* tools::mapf(string path, size_t* size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Could not open file \"%s\".\n", path.c_str());
+        exit(74);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        fprintf(stderr, "Could not read file \"%s\".\n", path.c_str());
+        exit(74);
+    }
+    *size = st.st_size;
+
+    // reserve one zeroed byte more than the file so that the mapping
+    // is terminated even if the file ends exactly at a page boundary
+    char *buffer = (char *)mmap(NULL, *size + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+    {
+        fprintf(stderr, "Not enough memory to read \"%s\".\n", path.c_str());
+        exit(74);
+    }
+    if (*size && mmap(buffer, *size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        fprintf(stderr, "Could not read file \"%s\".\n", path.c_str());
+        exit(74);
+    }
+
+    close(fd);
+    return buffer;
+}
+
+// unmap file mapped by mapf
+void tools::unmapf(const char* buffer, size_t size)
+{
+    munmap((void *)buffer, size + 1);
+}
+
 // write string to file
 void tools::writef(string path, string text)
 {
@@ -216,3 +261,18 @@ void tools::writef(string path, string text)
     file_out << text;
     file_out.close();
 }
+
+// create a new file with a unique name from a mkstemps template
+// (e.g. "name.XXXXXX.o" with suffixlen 2) and return its path
+string tools::mktempf(string templ, int suffixlen)
+{
+    int fd = mkstemps(&templ[0], suffixlen);
+    if (fd < 0)
+    {
+        cerr << "failed to create " << templ << '\n';
+        exit(74);
+    }
+
+    close(fd);
+    return templ;
+}
@@ -5,7 +5,6 @@ Status TypeChecker::check(string path, ccp source, AST* astree)
 {
 	_infile = path;
 	_error_dispatcher = ErrorDispatcher();
-	_type_stack = stack<ParsedType*>();
 
 	_panic_mode = false;
 	_had_error = false;
@@ -14,7 +13,6 @@ Status TypeChecker::check(string path, ccp source, AST* astree)
 	{
 		if(!node) continue;
 		node->accept(this);
-		pop();
 		_panic_mode = false;
 	}
 
@@ -22,7 +20,7 @@ Status TypeChecker::check(string path, ccp source, AST* astree)
 	return _had_error ? STATUS_TYPE_ERROR : STATUS_SUCCESS;
 }
 
-void TypeChecker::error_at(Token *token, string message)
+void TypeChecker::error_at(Token token, string message)
 {
 	if(_panic_mode) return;
 
@@ -31,62 +29,51 @@ void TypeChecker::error_at(Token *token, string message)
 
 	if(lint_args.type == LINT_GET_DIAGNOSTICS)
 	{
-		lint_output_diagnostic_object(token, message, "error");
+		lint_output_diagnostic_object(&token, message, "error");
 		
 		// TODO:? array and surrounding object ended in synchronize()
 		lint_output_diagnostic_object_end();
 	}
 	else if(lint_args.type == LINT_NONE)
 	{
-		_error_dispatcher.error_at_token(token, "Type Inference Error", message.c_str());
+		_error_dispatcher.error_at_token(&token, "Type Inference Error", message.c_str());
 
 		// print token
 		cerr << endl;
-		_error_dispatcher.print_token_marked(token, COLOR_RED);
+		_error_dispatcher.print_token_marked(&token, COLOR_RED);
 		
 		ABORT(STATUS_TYPE_ERROR);
 		// synchronize?
 	}
 }
 
-void TypeChecker::warning_at(Token *token, string message, bool print_token)
+void TypeChecker::warning_at(Token token, string message, bool print_token)
 {
 	if(_panic_mode) return;
 	else if(lint_args.type == LINT_GET_DIAGNOSTICS)
 	{
-		lint_output_diagnostic_object(token, message, "warning");
+		lint_output_diagnostic_object(&token, message, "warning");
 
 		// TODO:? array and surrounding object ended in synchronize()
 		lint_output_diagnostic_object_end();
 	}
 	else if(lint_args.type == LINT_NONE)
 	{
-		_error_dispatcher.warning_at_token(token, "Type Inference Warning", message.c_str());
+		_error_dispatcher.warning_at_token(&token, "Type Inference Warning", message.c_str());
 		if(print_token)
 		{
-			cerr << endl;
-			_error_dispatcher.print_token_marked(token, COLOR_PURPLE);
+			print_diagnostic("\n");
+			_error_dispatcher.print_token_marked(&token, COLOR_PURPLE);
 		}
 	}
 }
 
-void TypeChecker::push(ParsedType* type)
-{
-	// just a lil push
-	_type_stack.push(type);
-}
-
-ParsedType* TypeChecker::pop()
-{
-	ASSERT_OR_THROW_INTERNAL_ERROR(!_type_stack.empty(), "during type checking");
-	ParsedType* type = _type_stack.top();
-	_type_stack.pop();
-	return type;
-}
-
 // check if right is compatible with from and return
 // "compromise" decided by original
 // returns a nullptr if invalid
+// the compromise is original's type as is (adapted's if only adapted is a pointer).
+// neither type is changed, so the callers compare the expression's type against
+// the unchanged target and narrowing initializations such as "%a i32 1.5" warn
 ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted)
 {
 	// DEBUG_PRINT_F_MSG("resolve_types(%s, %s) (%s)", original->to_c_string(), adapted->to_c_string(),
@@ -105,18 +92,18 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 			{
 				case TYPE_CHARACTER:
 				case TYPE_INTEGER:
-					return original->copy_change_lex(TYPE_INTEGER);
+					return original->copy();
 				case TYPE_FLOAT:
-					return original->copy_change_lex(TYPE_FLOAT);
+					return original->copy();
 				default: return nullptr;
 			}
 			case TYPE_CHARACTER: switch(AS_LEX(adapted))
 			{
 				case TYPE_BOOL:
 				case TYPE_INTEGER:
-					return original->copy_change_lex(TYPE_INTEGER);
+					return original->copy();
 				case TYPE_FLOAT:
-					return original->copy_change_lex(TYPE_FLOAT);
+					return original->copy();
 				default: return nullptr;
 				
 			}
@@ -124,9 +111,9 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 			{
 				case TYPE_BOOL:
 				case TYPE_CHARACTER:
-					return original->copy_change_lex(TYPE_INTEGER);
+					return original->copy();
 				case TYPE_FLOAT:
-					return original->copy_change_lex(TYPE_FLOAT);
+					return original->copy();
 				default: return nullptr;
 				
 			}
@@ -135,7 +122,7 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 				case TYPE_BOOL:
 				case TYPE_INTEGER:
 				case TYPE_CHARACTER:
-					return original->copy_change_lex(TYPE_FLOAT);
+					return original->copy();
 				default: return nullptr;
 			}
 			default: return nullptr;
@@ -153,7 +140,7 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 			case TYPE_BOOL:
 			case TYPE_INTEGER:
 			case TYPE_CHARACTER:
-				return original->copy_change_lex(TYPE_INTEGER);
+				return original->copy();
 
 			default: return nullptr;
 		}
@@ -170,7 +157,7 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 			case TYPE_INTEGER:
 			case TYPE_CHARACTER:
 			case TYPE_FLOAT:
-				return adapted->copy_change_lex(TYPE_INTEGER);
+				return adapted->copy();
 
 			default: return nullptr;
 		}
@@ -180,6 +167,20 @@ ParsedType* TypeChecker::resolve_types(ParsedType* original, ParsedType* adapted
 	return nullptr;
 }
 
+// the type both operands of a comparison are converted to. that's the wider
+// one (floats before integers), so neither side is truncated before comparing
+ParsedType* TypeChecker::comparison_type(ParsedType* left, ParsedType* right)
+{
+	if(left->is_pointer() || right->is_pointer()) return resolve_types(left, right);
+
+	if(AS_LEX(left) == TYPE_FLOAT && AS_LEX(right) != TYPE_FLOAT) return resolve_types(left, right);
+	if(AS_LEX(right) == TYPE_FLOAT && AS_LEX(left) != TYPE_FLOAT) return resolve_types(right, left);
+
+	uint leftbits = left->get_llvm_type()->getPrimitiveSizeInBits();
+	uint rightbits = right->get_llvm_type()->getPrimitiveSizeInBits();
+	return rightbits > leftbits ? resolve_types(right, left) : resolve_types(left, right);
+}
+
 bool TypeChecker::can_cast_types(ParsedType* from, ParsedType* to)
 {
 	// DEBUG_PRINT_F_MSG("can_cast_types(%s, %s) (%s)", from->to_c_string(), to->to_c_string(),
@@ -270,8 +271,8 @@ bool TypeChecker::can_cast_types(ParsedType* from, ParsedType* to)
 }
 
 // =========================================
-#define VISIT(_node) void TypeChecker::visit(_node* node)
-#define ACCEPT_AND_POP(node) { if(node) { node->accept(this); pop(); } }
+#define VISIT(_node) ParsedType* TypeChecker::visit(_node* node)
+#define ACCEPT_IF_SET(node) { if(node) node->accept(this); }
 
 #define ERROR_AT(token, format, ...) error_at(token, tools::fstr(format, __VA_ARGS__))
 #define CANNOT_CONVERT_ERROR_AT(token, from, to) \
@@ -284,14 +285,14 @@ bool TypeChecker::can_cast_types(ParsedType* from, ParsedType* to)
 	original->to_c_string(), result->to_c_string()), true)
 
 // === Statements ===
-// all nodes should have a stack effect of 1
+// statements have no type, so they return nullptr
 
 VISIT(FuncDeclNode)
 {
-	ACCEPT_AND_POP(node->_body)
+	ACCEPT_IF_SET(node->_body)
 	_panic_mode = false;
 	
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(VarDeclNode)
@@ -300,27 +301,25 @@ VISIT(VarDeclNode)
 
 	if(node->_expr)
 	{
-		node->_expr->accept(this);
-		ParsedType* exprtype = pop();
+		ParsedType* exprtype = node->_expr->accept(this);
 		ParsedType* result = resolve_types(vartype, exprtype);
 
 		if(!can_cast_types(result ? result : exprtype, vartype))
-			ERROR_AT(&node->_token, "Cannot initialize variable of type " COLOR_BOLD \
+			ERROR_AT(node->token(), "Cannot initialize variable of type " COLOR_BOLD \
 			"'%s'" COLOR_NONE " with expression of type " COLOR_BOLD "'%s'" COLOR_NONE ".",
 			vartype->to_c_string(), exprtype->to_c_string());
 		else if(!exprtype->eq(vartype, true))
-			CONVERSION_WARNING_AT(&node->_token, exprtype, vartype);			
+			CONVERSION_WARNING_AT(node->token(), exprtype, vartype);			
 
 		node->_expr->_cast_to = vartype;
 	}
 	
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(AssignNode)
 {
-	node->_expr->accept(this);
-	ParsedType* exprtype = pop();
+	ParsedType* exprtype = node->_expr->accept(this);
 	ParsedType* vartype = node->_expected_type;
 
 	// handle subscript
@@ -328,8 +327,8 @@ VISIT(AssignNode)
 	{
 		if(!vartype->is_pointer())
 		{
-			ERROR_AT(&subscript->_token, "Subscripted target is not a pointer.", 0);
-			return;
+			ERROR_AT(subscript->token(), "Subscripted target is not a pointer.", 0);
+			return nullptr;
 		}
 		else vartype = vartype->copy_element_of();
 	}
@@ -337,75 +336,74 @@ VISIT(AssignNode)
 	ParsedType* result = resolve_types(vartype, exprtype);
 
 	if(!can_cast_types(result, vartype)) 
-		ERROR_AT(&node->_token, "Cannot implicitly convert expression of type " COLOR_BOLD \
+		ERROR_AT(node->token(), "Cannot implicitly convert expression of type " COLOR_BOLD \
 		"'%s'" COLOR_NONE " to target's type " COLOR_BOLD "'%s'" COLOR_NONE ".",
 		exprtype->to_c_string(), vartype->to_c_string());
 	else if(!exprtype->eq(vartype, true))
-		CONVERSION_WARNING_AT(&node->_token, exprtype, vartype);
+		CONVERSION_WARNING_AT(node->token(), exprtype, vartype);
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(IfNode)
 {
-	ACCEPT_AND_POP(node->_cond);
+	ACCEPT_IF_SET(node->_cond);
 	_panic_mode = false;
 
-	ACCEPT_AND_POP(node->_then);
+	ACCEPT_IF_SET(node->_then);
 	_panic_mode = false;
 
-	ACCEPT_AND_POP(node->_else);
+	ACCEPT_IF_SET(node->_else);
 	_panic_mode = false;
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(LoopNode)
 {
-	ACCEPT_AND_POP(node->_init);
+	ACCEPT_IF_SET(node->_init);
 	_panic_mode = false;
 
-	ACCEPT_AND_POP(node->_cond);
+	ACCEPT_IF_SET(node->_cond);
 	_panic_mode = false;
 
-	ACCEPT_AND_POP(node->_incr);
+	ACCEPT_IF_SET(node->_incr);
 	_panic_mode = false;
 
-	ACCEPT_AND_POP(node->_body);
+	ACCEPT_IF_SET(node->_body);
 	_panic_mode = false;
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(ReturnNode)
 {
 	if(node->_expr)
 	{
-		node->_expr->accept(this);
-		ParsedType* exprtype = pop();
+		ParsedType* exprtype = node->_expr->accept(this);
 		ParsedType* functype = node->_expected_type;
 
 		ParsedType* result = resolve_types(functype, exprtype);
 
 		if(!can_cast_types(result, functype)) 
-			ERROR_AT(&node->_token, "Cannot implicitly convert return type " COLOR_BOLD \
+			ERROR_AT(node->token(), "Cannot implicitly convert return type " COLOR_BOLD \
 			"'%s'" COLOR_NONE " to function's return type " COLOR_BOLD "'%s'" COLOR_NONE ".",
 			exprtype->to_c_string(), functype->to_c_string());
 		
 		node->_expr->_cast_to = functype;
 	}
 
-	push(nullptr);
+	return nullptr;
 }
 
 VISIT(BlockNode)
 {
 	for(auto& subnode : node->_statements)
 	{
-		ACCEPT_AND_POP(subnode);
+		ACCEPT_IF_SET(subnode);
 		_panic_mode = false;
 	}
-	push(nullptr);
+	return nullptr;
 }
 
 // === Expressions ===
@@ -417,57 +415,48 @@ VISIT(LogicalNode)
 
 	ParsedType* booltype = PTYPE(TYPE_BOOL);
 
-	if(node->_token.type == TOKEN_QUESTION)
+	if(node->_optype == TOKEN_QUESTION)
 	{
-		node->_left->accept(this);
-		ParsedType* cond = pop();
-		if(!can_cast_types(cond, booltype))	CANNOT_CONVERT_ERROR_AT(&node->_left->_token, cond, booltype);
+		ParsedType* cond = node->_left->accept(this);
+		if(!can_cast_types(cond, booltype))	CANNOT_CONVERT_ERROR_AT(node->_left->token(), cond, booltype);
 		node->_left->_cast_to = booltype;
 
-		node->_middle->accept(this);
-		node->_right->accept(this);
-		ParsedType* right = pop();
-		ParsedType* left = pop();
+		ParsedType* left = node->_middle->accept(this);
+		ParsedType* right = node->_right->accept(this);
 		ParsedType* result = resolve_types(left, right);
 
-		if(result == nullptr) CANNOT_CONVERT_ERROR_AT(&node->_right->_token, left, right);
-		else if(!left->eq(result)) CONVERSION_WARNING_AT(&node->_middle->_token, left, result);
-		else if(!right->eq(result)) CONVERSION_WARNING_AT(&node->_right->_token, right, result);
+		if(result == nullptr) CANNOT_CONVERT_ERROR_AT(node->_right->token(), left, right);
+		else if(!left->eq(result)) CONVERSION_WARNING_AT(node->_middle->token(), left, result);
+		else if(!right->eq(result)) CONVERSION_WARNING_AT(node->_right->token(), right, result);
 		
 		node->_middle->_cast_to = result;
 		node->_right->_cast_to = result;
 
-		push(result);
+		return result;
 	}
 	else
 	{
-		node->_left->accept(this);
-		node->_right->accept(this);
-		
-		ParsedType* right = pop();
-		ParsedType* left = pop();
+		ParsedType* left = node->_left->accept(this);
+		ParsedType* right = node->_right->accept(this);
 
-		// if(result == TYPE_NONE) CANNOT_CONVERT_ERROR_AT(&node->_right->_token, left, right);
-		if(!can_cast_types(left, booltype)) CANNOT_CONVERT_ERROR_AT(&node->_left->_token, left, booltype);
-		if(!can_cast_types(right, booltype)) CANNOT_CONVERT_ERROR_AT(&node->_right->_token, right, booltype);
+		// if(result == TYPE_NONE) CANNOT_CONVERT_ERROR_AT(node->_right->token(), left, right);
+		if(!can_cast_types(left, booltype)) CANNOT_CONVERT_ERROR_AT(node->_left->token(), left, booltype);
+		if(!can_cast_types(right, booltype)) CANNOT_CONVERT_ERROR_AT(node->_right->token(), right, booltype);
 
-		if(!left->eq(booltype, true)) CONVERSION_WARNING_AT(&node->_left->_token, left, booltype);
-		if(!right->eq(booltype, true)) CONVERSION_WARNING_AT(&node->_right->_token, right, booltype);
+		if(!left->eq(booltype, true)) CONVERSION_WARNING_AT(node->_left->token(), left, booltype);
+		if(!right->eq(booltype, true)) CONVERSION_WARNING_AT(node->_right->token(), right, booltype);
 		
 		node->_left->_cast_to = booltype;
 		node->_right->_cast_to = booltype;
 
-		push(booltype);
+		return booltype;
 	}
 }
 
 VISIT(BinaryNode)
 {
-	node->_left->accept(this);
-	node->_right->accept(this);
-
-	ParsedType* right = pop();
-	ParsedType* left = pop();
+	ParsedType* left = node->_left->accept(this);
+	ParsedType* right = node->_right->accept(this);
 
 	if(node->_optype == TOKEN_AND
 	|| node->_optype == TOKEN_PIPE
@@ -477,43 +466,52 @@ VISIT(BinaryNode)
 
 		if(!can_cast_types(left, inttype))
 		{
-			ERROR_AT(&node->_left->_token, "Cannot implicitly convert expression of type " COLOR_BOLD "'%s'" COLOR_NONE
+			ERROR_AT(node->_left->token(), "Cannot implicitly convert expression of type " COLOR_BOLD "'%s'" COLOR_NONE
 			" to type " COLOR_BOLD "'integer'" COLOR_NONE " required by binary operator '%.*s'.",
-			left->to_c_string(), node->_token.length, node->_token.start);
+			left->to_c_string(), node->token().length, node->token().start);
 		}
 		if(!can_cast_types(right, inttype))
 		{
-			ERROR_AT(&node->_right->_token, "Cannot implicitly convert expression of type " COLOR_BOLD "'%s'" COLOR_NONE
+			ERROR_AT(node->_right->token(), "Cannot implicitly convert expression of type " COLOR_BOLD "'%s'" COLOR_NONE
 			" to type " COLOR_BOLD "'integer'" COLOR_NONE " required by binary operator '%.*s'.",
-			right->to_c_string(), node->_token.length, node->_token.start);
+			right->to_c_string(), node->token().length, node->token().start);
 		}
-		if(!left->eq(inttype, true)) CONVERSION_WARNING_AT(&node->_left->_token, left, inttype);
-		if(!right->eq(inttype, true)) CONVERSION_WARNING_AT(&node->_right->_token, right, inttype);
+		if(!left->eq(inttype, true)) CONVERSION_WARNING_AT(node->_left->token(), left, inttype);
+		if(!right->eq(inttype, true)) CONVERSION_WARNING_AT(node->_right->token(), right, inttype);
 
 		node->_left->_cast_to = inttype;
 		node->_right->_cast_to = inttype;
 		node->_cast_to = inttype; // in case nothing else sets it
 
-		push(inttype);
-		return;
+		return inttype;
 	}
 	if(node->_optype == TOKEN_EQUAL_EQUAL
 	|| node->_optype == TOKEN_SLASH_EQUAL
 	|| node->_optype == TOKEN_GREATER
 	|| node->_optype == TOKEN_GREATER_EQUAL
 	|| node->_optype == TOKEN_LESS
-	|| node->_optype == TOKEN_LESS_EQUAL) // inqualty op (pushes bool)
+	|| node->_optype == TOKEN_LESS_EQUAL) // inqualty op (returns bool)
 	{
+		// the operands are compared in their common type, only the result is a bool
 		ParsedType* booltype = PTYPE(TYPE_BOOL);
-		if(!can_cast_types(left, booltype)) CANNOT_CONVERT_ERROR_AT(&node->_left->_token, left, booltype);
-		if(!can_cast_types(right, booltype)) CANNOT_CONVERT_ERROR_AT(&node->_right->_token, right, booltype);
-
-		node->_left->_cast_to = booltype;
-		node->_right->_cast_to = booltype;
+		ParsedType* operandtype = comparison_type(left, right);
 		node->_cast_to = booltype;
 
-		push(booltype);
-		return;
+		if(operandtype == nullptr)
+		{
+			ERROR_AT(node->token(), "Cannot compare expressions of type " COLOR_BOLD "'%s'" COLOR_NONE
+			" and " COLOR_BOLD "'%s'" COLOR_NONE ".", left->to_c_string(), right->to_c_string());
+			return booltype;
+		}
+		if(!can_cast_types(left, operandtype)) CANNOT_CONVERT_ERROR_AT(node->_left->token(), left, operandtype);
+		if(!can_cast_types(right, operandtype)) CANNOT_CONVERT_ERROR_AT(node->_right->token(), right, operandtype);
+		if(!left->eq(operandtype, true)) CONVERSION_WARNING_AT(node->_left->token(), left, operandtype);
+		if(!right->eq(operandtype, true)) CONVERSION_WARNING_AT(node->_right->token(), right, operandtype);
+
+		node->_left->_cast_to = operandtype;
+		node->_right->_cast_to = operandtype;
+
+		return booltype;
 	}
 	else // normal op
 	{
@@ -523,7 +521,7 @@ VISIT(BinaryNode)
 			node->_optype == TOKEN_MINUS ||
 			node->_optype == TOKEN_STAR  ||
 			node->_optype == TOKEN_SLASH ))
-			// CONVERSION_WARNING_AT(&node->_right->_token, right, PTYPE(TYPE_INTEGER));
+			// CONVERSION_WARNING_AT(node->_right->token(), right, PTYPE(TYPE_INTEGER));
 			right = PTYPE(TYPE_INTEGER);
 		
 		if(left->is_pointer() && (
@@ -531,67 +529,59 @@ VISIT(BinaryNode)
 			node->_optype == TOKEN_MINUS ||
 			node->_optype == TOKEN_STAR  ||
 			node->_optype == TOKEN_SLASH ))
-			// CONVERSION_WARNING_AT(&node->_left->_token, left, PTYPE(TYPE_INTEGER));
+			// CONVERSION_WARNING_AT(node->_left->token(), left, PTYPE(TYPE_INTEGER));
 			left = PTYPE(TYPE_INTEGER);
 
 		ParsedType* result = resolve_types(left, right);
 
 		if(result == nullptr) 
 		{
-			if(!right->eq(left)) CANNOT_CONVERT_ERROR_AT(&node->_right->_token, left, right);
-			else ERROR_AT(&node->_token, "Cannot peform binary operation on expressions of type " \
+			if(!right->eq(left)) CANNOT_CONVERT_ERROR_AT(node->_right->token(), left, right);
+			else ERROR_AT(node->token(), "Cannot peform binary operation on expressions of type " \
 				COLOR_BOLD "'%s'" COLOR_NONE ".", right->to_c_string());
 		}
-		if(!left->eq(result, true)) CONVERSION_WARNING_AT(&node->_left->_token, left, result);
-		if(!right->eq(result, true)) CONVERSION_WARNING_AT(&node->_right->_token, right, result);
+		if(!left->eq(result, true)) CONVERSION_WARNING_AT(node->_left->token(), left, result);
+		if(!right->eq(result, true)) CONVERSION_WARNING_AT(node->_right->token(), right, result);
 
 		node->_left->_cast_to = result;
 		node->_right->_cast_to = result;
 		node->_cast_to = result; // in case nothing else sets it
 
-		push(result);
-		return;
+		return result;
 	}
 }
 
 VISIT(CastNode)
 {
-	node->_expr->accept(this);
-	ParsedType* srctype = pop();
+	ParsedType* srctype = node->_expr->accept(this);
 	ParsedType* desttype = node->_type;
 
 	if(!can_cast_types(srctype, desttype))
-		CANNOT_CONVERT_ERROR_AT(&node->_token, srctype, desttype);
+		CANNOT_CONVERT_ERROR_AT(node->token(), srctype, desttype);
 	
-	push(node->_type);
+	return node->_type;
 }
 
 VISIT(UnaryNode)
 {
-	node->_expr->accept(this);
-	ParsedType* type = pop();
+	ParsedType* type = node->_expr->accept(this);
 
 	if(type->is_pointer()) switch(node->_optype) // we're dealing with a pointer
 	{
 		case TOKEN_STAR:
 		{
-			node->_expr->_cast_to = type->copy_element_of();
-			node->_expr->_cast_to->_keep_as_reference = true;
-			push(node->_expr->_cast_to);
-			break;
+			node->_expr->_cast_to = type->copy_element_of()->copy_keep_as_reference();
+			return node->_expr->_cast_to;
 		}
 		case TOKEN_AND:
 		{
-			node->_expr->_cast_to = type->copy_pointer_to();
-			node->_expr->_cast_to->_keep_as_reference = true;
-			push(node->_expr->_cast_to);
-			break;
+			node->_expr->_cast_to = type->copy_pointer_to()->copy_keep_as_reference();
+			return node->_expr->_cast_to;
 		}
 		case TOKEN_BANG:
 		{
 			node->_expr->_cast_to = PTYPE(TYPE_BOOL);
-			push(node->_expr->_cast_to);
-			break;
+			return node->_expr->_cast_to;
 		}
 
 		case TOKEN_MINUS:
@@ -600,9 +590,8 @@ VISIT(UnaryNode)
 		{
 			// pointer arithmetic :(
 			node->_expr->_cast_to = PTYPE(TYPE_INTEGER);
-			push(node->_expr->_cast_to);
-			CONVERSION_WARNING_AT(&node->_token, type, node->_expr->_cast_to);
-			break;
+			CONVERSION_WARNING_AT(node->token(), type, node->_expr->_cast_to);
+			return node->_expr->_cast_to;
 		}
 
 		default: THROW_INTERNAL_ERROR("during type checking");
@@ -612,34 +601,31 @@ VISIT(UnaryNode)
 		case TOKEN_STAR:
 		{
 			// can only dereference if pointer depth > 0
-			error_at(&node->_token, "Cannot dereference non-pointer value.");
-			break;
+			error_at(node->token(), "Cannot dereference non-pointer value.");
+			return ParsedType::new_invalid();
 		}
 		case TOKEN_AND:
 		{
 			// can only get address of "lvalue"
 			if(!type->_is_reference)
 			{
-				error_at(&node->_token, "Cannot get address of non-reference value.");
-				break;
+				error_at(node->token(), "Cannot get address of non-reference value.");
+				return ParsedType::new_invalid();
 			}
 			if(type->is_constant())
 			{
 				// taking the address of a constant is bad practice
-				warning_at(&node->_token, tools::fstr(
+				warning_at(node->token(), tools::fstr(
 					"Unary '&' operator discards constant-modifier from target type '%s'.", type->to_c_string()), true);
 			}
 
-			node->_expr->_cast_to = type->copy_pointer_to();
-			node->_expr->_cast_to->_keep_as_reference = true;
-			push(node->_expr->_cast_to);
-			break;
+			node->_expr->_cast_to = type->copy_pointer_to()->copy_keep_as_reference();
+			return node->_expr->_cast_to;
 		}
 		case TOKEN_BANG:
 		{
 			node->_expr->_cast_to = PTYPE(TYPE_BOOL);
-			push(node->_expr->_cast_to);
-			break;
+			return node->_expr->_cast_to;
 		}
 
 		case TOKEN_MINUS:
@@ -647,118 +633,109 @@ VISIT(UnaryNode)
 		case TOKEN_MINUS_MINUS:
 		{
 			node->_expr->_cast_to = type;
-			push(type);
-			break;
+			return type;
 		}
 
 		default: THROW_INTERNAL_ERROR("during type checking");
 	}
+	return nullptr;
 }
 
 VISIT(GroupingNode)
 {
-	node->_expr->accept(this);
+	return node->_expr->accept(this);
 }
 
 VISIT(SubscriptNode)
 {
-	node->_expr->accept(this);
-	ParsedType* exprtype = pop();
+	ParsedType* exprtype = node->_expr->accept(this);
 
 	// lhs must be pointer or array
 	if(!exprtype->get_depth())
 	{
-		ERROR_AT(&node->_token, "Subscripted value is not a pointer.", 0);
-		push(ParsedType::new_invalid());
-		return;
+		ERROR_AT(node->token(), "Subscripted value is not a pointer.", 0);
+		return ParsedType::new_invalid();
 	}
 
-	node->_index->accept(this);
-	ParsedType* indextype = pop();
+	ParsedType* indextype = node->_index->accept(this);
 
 	// try to cast rhs to int
 	if(!can_cast_types(indextype, PTYPE(TYPE_INTEGER)))
-		ERROR_AT(&node->_token, "Cannot convert from type " COLOR_BOLD "'%s'" \
+		ERROR_AT(node->token(), "Cannot convert from type " COLOR_BOLD "'%s'" \
 				COLOR_NONE " to integer type for subscript.", indextype->to_c_string());
 	
-	push(exprtype->copy_element_of());
+	return exprtype->copy_element_of();
 }
 
 
 VISIT(LiteralNode)
 {
-	switch(node->_token.type)
+	switch(node->_literal_type)
 	{
-		case TOKEN_INTEGER: 	node->_cast_to = PTYPE(TYPE_INTEGER);      push(node->_cast_to); break;
-		case TOKEN_FLOAT: 		node->_cast_to = PTYPE(TYPE_FLOAT); 	   push(node->_cast_to); break;
-		case TOKEN_CHARACTER: 	node->_cast_to = PTYPE(TYPE_CHARACTER);    push(node->_cast_to); break;
+		case TOKEN_INTEGER: 	node->_cast_to = PTYPE(TYPE_INTEGER);      return node->_cast_to;
+		case TOKEN_FLOAT: 		node->_cast_to = PTYPE(TYPE_FLOAT); 	   return node->_cast_to;
+		case TOKEN_CHARACTER: 	node->_cast_to = PTYPE(TYPE_CHARACTER);    return node->_cast_to;
 		case TOKEN_STRING: 		
 			node->_cast_to = PTYPE(TYPE_CHARACTER)->copy_pointer_to(); 
-			push(node->_cast_to); break;
+			return node->_cast_to;
 		default: THROW_INTERNAL_ERROR("during type checking");
 	}
+	return nullptr;
 }
 
 VISIT(ArrayNode)
 {
 	// get first expr
 	ParsedType* firsttype = PTYPE(TYPE_NONE);
-	if(node->_elements.size() >= 1)
-	{
-		node->_elements[0]->accept(this);
-		firsttype = pop();
-	}
+	if(node->_elements.size() >= 1) firsttype = node->_elements[0]->accept(this);
 
 	for(int i = 1; i < node->_elements.size(); i++)
 	{
-		node->_elements[i]->accept(this);
-		ParsedType* exprtype = pop();
+		ParsedType* exprtype = node->_elements[i]->accept(this);
 
 		ParsedType* result = resolve_types(firsttype, exprtype);
 		node->_elements[i]->_cast_to = firsttype;
 
 		if(!can_cast_types(result ? result : exprtype, firsttype))
-			ERROR_AT(&node->_elements[i]->_token, "Cannot implicitly convert argument of type" COLOR_BOLD \
+			ERROR_AT(node->_elements[i]->token(), "Cannot implicitly convert argument of type" COLOR_BOLD \
 			"'%s'" COLOR_NONE " to first element's type " COLOR_BOLD "'%s'" COLOR_NONE ".",
 			exprtype->to_c_string(), firsttype->to_c_string());
 	}
 
 	ParsedType* arrtype = firsttype->copy_pointer_to();
 	node->_cast_to = arrtype;
-	push(arrtype);
+	return arrtype;
 }
 
 VISIT(SizeOfNode)
 {
 	node->_cast_to = PTYPE(
-		GET_EVI_TYPE("sze")->_default_type,
-		GET_EVI_TYPE("sze")
+		GET_BUILTIN_EVI_TYPE(BUILTIN_SZE)->_default_type,
+		GET_BUILTIN_EVI_TYPE(BUILTIN_SZE)
 	);
 
-	push(node->_cast_to);
+	return node->_cast_to;
 }
 
 VISIT(ReferenceNode)
 {
-	node->_cast_to = node->_type->copy();
-	node->_cast_to->_is_reference = true;
-	push(node->_cast_to);
+	node->_cast_to = node->_type->copy()->copy_as_reference();
+	return node->_cast_to;
 }
 
 VISIT(CallNode)
 {
 	for(int i = 0; i < node->_func_params_count; i++)
 	{
-		node->_arguments[i]->accept(this);
-		ParsedType* exprtype = pop();
+		ParsedType* exprtype = node->_arguments[i]->accept(this);
 		ParsedType* argtype = node->_expected_arg_types[i];
 
 		if(!can_cast_types(exprtype, argtype)) 
-			ERROR_AT(&node->_arguments[i]->_token, "Cannot implicitly convert argument of type " COLOR_BOLD \
+			ERROR_AT(node->_arguments[i]->token(), "Cannot implicitly convert argument of type " COLOR_BOLD \
 			"'%s'" COLOR_NONE " to parameter's type " COLOR_BOLD "'%s'" COLOR_NONE ".",
 			exprtype->to_c_string(), argtype->to_c_string());
 		else if(!exprtype->eq(argtype, true))
-			CONVERSION_WARNING_AT(&node->_arguments[i]->_token, exprtype, argtype);
+			CONVERSION_WARNING_AT(node->_arguments[i]->token(), exprtype, argtype);
 
 		_panic_mode = false;
 	}
@@ -767,8 +744,7 @@ VISIT(CallNode)
 	for(int i = node->_func_params_count - 1; i < node->_arguments.size(); i++)
 	{
 		node->_arguments[i]->accept(this);
-		pop();
 	}
 
-	push(node->_ret_type);
+	return node->_ret_type;
 }
\ No newline at end of file
@@ -1,57 +1,138 @@
 #include "types.hpp"
 
-ParsedType::ParsedType(LexicalType lexical_type, EviType* evi_type,
-			   		   bool is_reference, ParsedType* subtype)
+#include <unordered_map>
+
+// the key of an interned type, subtypes are interned already
+struct ParsedTypeKey
+{
+	LexicalType lexical_type;
+	EviType* evi_type;
+	ParsedType* subtype;
+	bool is_constant;
+	bool is_reference;
+	bool keep_as_reference;
+
+	bool operator==(const ParsedTypeKey& rhs) const
+	{
+		return lexical_type == rhs.lexical_type && evi_type == rhs.evi_type && subtype == rhs.subtype
+			&& is_constant == rhs.is_constant && is_reference == rhs.is_reference
+			&& keep_as_reference == rhs.keep_as_reference;
+	}
+};
+
+struct ParsedTypeKeyHash
+{
+	size_t operator()(const ParsedTypeKey& key) const
+	{
+		size_t hash = std::hash<void*>()(key.evi_type) ^ (std::hash<void*>()(key.subtype) << 1);
+		return hash ^ (key.lexical_type << 3 | key.is_constant << 2 | key.is_reference << 1 | key.keep_as_reference);
+	}
+};
+
+// the types of the compilation running on this thread. when its arena
+// is destroyed, so is the interner and the next compilation starts anew
+struct ParsedTypeInterner;
+static thread_local ParsedTypeInterner* __interner = nullptr;
+
+struct ParsedTypeInterner
 {
-	_lexical_type = lexical_type;
+	unordered_map<ParsedTypeKey, ParsedType*, ParsedTypeKeyHash> types;
+	ParsedType* invalid = nullptr;
+
+	~ParsedTypeInterner() { __interner = nullptr; }
+};
 
-	if(evi_type) _evi_type = evi_type;
-	else switch(lexical_type)
+static ParsedTypeInterner* get_interner()
+{
+	if(!__interner)
+	{
+		__interner = new(__arena->allocate(sizeof(ParsedTypeInterner), alignof(ParsedTypeInterner))) ParsedTypeInterner();
+		__arena->add_destructor(__interner);
+	}
+	return __interner;
+}
+
+ParsedType* ParsedType::intern(LexicalType lexical_type, EviType* evi_type, ParsedType* subtype,
+							   bool is_constant, bool is_reference, bool keep_as_reference)
+{
+	ParsedTypeKey key = { lexical_type, evi_type, subtype, is_constant, is_reference, keep_as_reference };
+	ParsedTypeInterner* interner = get_interner();
+	auto it = interner->types.find(key);
+	if(it != interner->types.end()) return it->second;
+
+	// the printed name is a string, so the type needs its destructor
+	ParsedType* type = new ParsedType();
+	__arena->add_destructor(type);
+	type->_lexical_type = lexical_type;
+	type->_evi_type = evi_type;
+	type->_subtype = subtype;
+	type->_depth = subtype ? subtype->_depth + 1 : 0;
+	type->_is_constant = is_constant;
+	type->_is_reference = is_reference;
+	type->_keep_as_reference = keep_as_reference;
+
+	bool qualified = is_constant || is_reference || keep_as_reference || (subtype && subtype->_unqualified != subtype);
+	type->_unqualified = qualified ? intern(lexical_type, evi_type,
+		subtype ? subtype->_unqualified : nullptr, false, false, false) : type;
+
+	interner->types.insert(pair<ParsedTypeKey, ParsedType*>(key, type));
+	return type;
+}
+
+ParsedType* ParsedType::get(LexicalType lexical_type, EviType* evi_type,
+			   				bool is_reference, ParsedType* subtype)
+{
+	if(!evi_type) switch(lexical_type)
 	{
-		case TYPE_BOOL: 	 _evi_type = GET_EVI_TYPE("bln"); break;
-		case TYPE_CHARACTER: _evi_type = GET_EVI_TYPE("chr"); break;
-		case TYPE_INTEGER: 	 _evi_type = GET_EVI_TYPE("i32"); break;
-		case TYPE_FLOAT: 	 _evi_type = GET_EVI_TYPE("dbl"); break;
-		case TYPE_VOID: 	 _evi_type = GET_EVI_TYPE("nll"); break;
+		case TYPE_BOOL: 	 evi_type = GET_BUILTIN_EVI_TYPE(BUILTIN_BLN); break;
+		case TYPE_CHARACTER: evi_type = GET_BUILTIN_EVI_TYPE(BUILTIN_CHR); break;
+		case TYPE_INTEGER: 	 evi_type = GET_BUILTIN_EVI_TYPE(BUILTIN_I32); break;
+		case TYPE_FLOAT: 	 evi_type = GET_BUILTIN_EVI_TYPE(BUILTIN_DBL); break;
+		case TYPE_VOID: 	 evi_type = GET_BUILTIN_EVI_TYPE(BUILTIN_NLL); break;
 		case TYPE_NONE:		 // break;
 		default: THROW_INTERNAL_ERROR("in type construction");
 	}
 
-	_is_reference = is_reference;
-	_keep_as_reference = false;
-	_invalid = false;
-	_subtype = subtype;
+	return intern(lexical_type, evi_type, subtype, false, is_reference, false);
 }
 
 ParsedType* ParsedType::new_invalid()
 {
-	ParsedType* type = new ParsedType();
-	type->_invalid = true;
-	return type;
+	ParsedTypeInterner* interner = get_interner();
+	if(!interner->invalid)
+	{
+		interner->invalid = new ParsedType();
+		interner->invalid->_invalid = true;
+		interner->invalid->_unqualified = interner->invalid;
+	}
+	return interner->invalid;
 }
 
 ParsedType* ParsedType::copy()
 {
 	ASSERT_OR_THROW_INTERNAL_ERROR(!is_invalid(), "during llvm type generation");
+	return intern(_lexical_type, _evi_type, _subtype ? _subtype->copy() : nullptr, _is_constant, false, false);
+}
 
-	ParsedType* ret = new ParsedType(_lexical_type, _evi_type, false, nullptr);
-	ret->_is_constant = _is_constant;
-	if(_subtype) ret->_subtype = _subtype->copy();
-	return ret;
+ParsedType* ParsedType::copy_change_constant(bool constant)
+{
+	return intern(_lexical_type, _evi_type, _subtype, constant, _is_reference, _keep_as_reference);
 }
 
-ParsedType* ParsedType::copy_change_lex(LexicalType type)
+ParsedType* ParsedType::copy_as_reference()
 {
-	ParsedType* ret = this->copy();
-	set_lex_type(type);
-	return ret;
+	return intern(_lexical_type, _evi_type, _subtype, _is_constant, true, _keep_as_reference);
+}
+
+ParsedType* ParsedType::copy_keep_as_reference()
+{
+	return intern(_lexical_type, _evi_type, _subtype, _is_constant, _is_reference, true);
 }
 
 ParsedType* ParsedType::copy_pointer_to()
 {
-	ParsedType* ret = this->copy();
-	ret->_subtype = this->copy();
-	return ret;
+	ParsedType* element = this->copy();
+	return intern(_lexical_type, _evi_type, element, _is_constant, false, false);
 }
 
 ParsedType* ParsedType::copy_element_of()
@@ -60,40 +141,42 @@ ParsedType* ParsedType::copy_element_of()
 	return _subtype->copy();
 }
 
-void ParsedType::set_lex_type(LexicalType type)
-{
-	_lexical_type = type;
-	if(_subtype) _subtype->set_lex_type(type);
-}
-
 
 string ParsedType::to_string(bool __first)
 {
 	if(is_invalid()) return "???";
 
-	string str = _subtype ? _subtype->to_string(false) + '*' : _evi_type->_name;
-	if(_is_constant && __first) return '!' + str;
-	else return str;
+	// only the outermost type shows its constant-modifier
+	if(!__first) return _unqualified->to_string();
+	if(_string.empty())
+	{
+		_string = _subtype ? _subtype->to_string(false) + '*' : _evi_type->_name;
+		if(_is_constant) _string = '!' + _string;
+	}
+	return _string;
 }
 
 ccp ParsedType::to_c_string()
 {
-	// ez
-	return strdup(to_string().c_str());
+	if(is_invalid()) return "???";
+	to_string();
+	return _string.c_str();
 }
 
 llvm::Type* ParsedType::get_llvm_type()
 {
 	ASSERT_OR_THROW_INTERNAL_ERROR(!is_invalid(), "during llvm type generation");
+	if(_llvm_type) return _llvm_type;
 
 	if(_subtype) 
 	{
 		// for llvm void* is invalid
 		if(!_subtype->is_pointer() && _subtype->_lexical_type == TYPE_VOID)
-			return llvm::IntegerType::getInt8PtrTy(__context);
-		return _subtype->get_llvm_type()->getPointerTo();
+			_llvm_type = llvm::IntegerType::getInt8PtrTy(__context);
+		else _llvm_type = _subtype->get_llvm_type()->getPointerTo();
 	}
-	else return _evi_type->_llvm_type;
+	else _llvm_type = _evi_type->_llvm_type;
+	return _llvm_type;
 }
 
 
@@ -102,10 +185,9 @@ bool ParsedType::eq(ParsedType* rhs, bool simple)
 	if(simple && (!get_depth() && _lexical_type == TYPE_BOOL && !rhs->get_depth() && rhs->_lexical_type != TYPE_VOID))
 		return true;
 
-	if(_subtype) return get_depth() == rhs->get_depth() && _subtype->eq(rhs->_subtype);
-
-	return _lexical_type == rhs->_lexical_type
-		&& (simple || _evi_type->eq(rhs->_evi_type));
+	// simple values only need the same lexical type
+	if(simple && !_subtype) return _lexical_type == rhs->_lexical_type;
+	return _unqualified == rhs->_unqualified;
 }
 
 uint ParsedType::get_alignment()
@@ -116,8 +198,7 @@ uint ParsedType::get_alignment()
 
 uint ParsedType::get_depth()
 {
-	if(_subtype) return _subtype->get_depth() + 1;
-	else return 0;
+	return _depth;
 }
 
 bool ParsedType::is_pointer()
@@ -156,7 +237,27 @@ bool EviType::eq(EviType* rhs)
 }
 
 
-ccp lexical_type_strings[TYPE_NONE];
+ccp lexical_type_strings[TYPE_NONE] = {
+	/*TYPE_BOOL*/ 		"boolean",
+	/*TYPE_CHARACTER*/ 	"character",
+	/*TYPE_INTEGER*/ 	"integer",
+	/*TYPE_FLOAT*/ 		"float",
+	/*TYPE_VOID*/ 		"void",
+};
 
-map<string, EviType*> __evi_types;
-llvm::LLVMContext __context;
\ No newline at end of file
+thread_local map<string, EviType*> __evi_types;
+thread_local EviType* __builtin_evi_types[BUILTIN_TYPE_COUNT];
+
+// every builtin type name has to be found as itself
+constexpr bool builtin_type_lookup_is_perfect()
+{
+	for(int i = 0; i < BUILTIN_TYPE_COUNT; i++)
+	{
+		size_t length = 0;
+		while(builtin_type_names[i][length]) length++;
+		if(find_builtin_type(builtin_type_names[i], length) != i) return false;
+	}
+	return true;
+}
+static_assert(builtin_type_lookup_is_perfect(), "find_builtin_type doesn't find every builtin type");
+thread_local llvm::LLVMContext __context;
\ No newline at end of file
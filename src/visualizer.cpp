@@ -182,7 +182,7 @@ VISIT(BlockNode)
 VISIT(LogicalNode)
 {
 	int thisnode = 0;
-	switch(node->_token.type)
+	switch(node->_optype)
 	{
 		case TOKEN_PIPE_PIPE: thisnode = ADD_NODE("||"); break;
 		case TOKEN_AND_AND:   thisnode = ADD_NODE("&&"); break;
@@ -285,7 +285,7 @@ VISIT(SubscriptNode)
 
 VISIT(LiteralNode)
 {
-	switch(node->_token.type)
+	switch(node->_literal_type)
 	{
 		case TOKEN_INTEGER: 	ADD_NODE(tools::fstr("%d", node->_int_value).c_str()); break;
 		case TOKEN_FLOAT:   	ADD_NODE(tools::fstr("%g", node->_float_value).c_str()); break;
@@ -301,7 +301,8 @@ VISIT(LiteralNode)
 		}
 		case TOKEN_STRING:
 		{
-			string str = tools::replacestr(node->_string_value, "\\", "&#92;");
+			string str = tools::replacestr(
+				string(node->_string_value.start, node->_string_value.length), "\\", "&#92;");
 			str = tools::replacestr(str, "'", "&#39;");
 
 			_stream << tools::fstr("\tnode%d [label=<&quot;%s&quot;>]\n", 
@@ -333,9 +334,9 @@ VISIT(SizeOfNode)
 
 VISIT(ReferenceNode)
 {
-	if(node->_token.type == TOKEN_VARIABLE_REF)
+	if(node->token().type == TOKEN_VARIABLE_REF)
 		ADD_NODE(tools::fstr("$%s", node->_variable.c_str()).c_str());
-	else if(node->_token.type == TOKEN_PARAMETER_REF)
+	else if(node->token().type == TOKEN_PARAMETER_REF)
 		ADD_NODE(tools::fstr("$%d", node->_parameter).c_str());
 	else THROW_INTERNAL_ERROR("during AST visualization");
 }
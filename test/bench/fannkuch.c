@@ -0,0 +1,59 @@
+// fannkuch-redux: counts the pancake flips of every permutation of N elements
+// (after the computer language benchmarks game, evi twin: fannkuch.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 10
+
+// rotates perm1 to its next permutation, starting at r
+// returns the new r or 0 once all permutations have been visited
+int next_permutation(int* perm1, int* count, int r)
+{
+	for(; r < N; r = r + 1)
+	{
+		int perm0 = perm1[0];
+		for(int i = 0; i < r; i = i + 1) perm1[i] = perm1[i + 1];
+		perm1[r] = perm0;
+
+		count[r] = count[r] - 1;
+		if(count[r] > 0) return r;
+	}
+	return 0;
+}
+
+int main()
+{
+	int *perm = (int*)malloc(sizeof(int) * N), *perm1 = (int*)malloc(sizeof(int) * N), *count = (int*)malloc(sizeof(int) * N);
+	for(int i = 0; i < N; i = i + 1) perm1[i] = i;
+
+	int checksum = 0, maxflips = 0, permcount = 0;
+	for(int r = N; r != 0; r = next_permutation(perm1, count, r))
+	{
+		for(; r != 1; r = r - 1) count[r - 1] = r;
+		for(int i = 0; i < N; i = i + 1) perm[i] = perm1[i];
+
+		// flip the first k + 1 elements until the first one is 0
+		int flips = 0;
+		for(int k = perm[0]; k != 0; k = perm[0])
+		{
+			for(int i = 0; i < (k + 1) / 2; i = i + 1)
+			{
+				int t = perm[i];
+				perm[i] = perm[k - i];
+				perm[k - i] = t;
+			}
+			flips = flips + 1;
+		}
+
+		if(flips > maxflips) maxflips = flips;
+		if((permcount & 1) == 0) checksum = checksum + flips;
+		else checksum = checksum - flips;
+		permcount = permcount + 1;
+	}
+
+	printf("%d\nPfannkuchen(%d) = %d\n", checksum, N, maxflips);
+
+	free(perm); free(perm1); free(count);
+	return 0;
+}
@@ -0,0 +1,33 @@
+// mandelbrot: counts the points of a SIZE x SIZE grid that lie in the mandelbrot set
+// (after the computer language benchmarks game, evi twin: mandelbrot.evi)
+
+#include <stdio.h>
+
+#define SIZE 1600
+#define ITERATIONS 50
+
+int main()
+{
+	int count = 0;
+	for(int py = 0; py < SIZE; py = py + 1)
+	{
+		double ci = 2.0 * (double)py / (double)SIZE - 1.0;
+		for(int px = 0; px < SIZE; px = px + 1)
+		{
+			double cr = 2.0 * (double)px / (double)SIZE - 1.5;
+			double zr = 0.0, zi = 0.0, tr = 0.0, ti = 0.0;
+
+			for(int i = 0; i < ITERATIONS && tr + ti <= 4.0; i = i + 1)
+			{
+				zi = 2.0 * zr * zi + ci;
+				zr = tr - ti + cr;
+				tr = zr * zr;
+				ti = zi * zi;
+			}
+			if(tr + ti <= 4.0) count = count + 1;
+		}
+	}
+
+	printf("%d\n", count);
+	return 0;
+}
@@ -0,0 +1,40 @@
+// matmul: multiplies two N x N matrices of doubles with the naive triple loop
+// (evi twin: matmul.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 800
+
+// c = a * b, all stored row-major
+void matmul(double* a, double* b, double* c)
+{
+	for(int i = 0; i < N; i = i + 1)
+	{
+		for(int j = 0; j < N; j = j + 1) c[i * N + j] = 0.0;
+		for(int k = 0; k < N; k = k + 1)
+		{
+			double aik = a[i * N + k];
+			for(int j = 0; j < N; j = j + 1) c[i * N + j] = c[i * N + j] + aik * b[k * N + j];
+		}
+	}
+}
+
+int main()
+{
+	double *a = (double*)malloc(sizeof(double) * N * N), *b = (double*)malloc(sizeof(double) * N * N), *c = (double*)malloc(sizeof(double) * N * N);
+	for(int i = 0; i < N; i = i + 1) for(int j = 0; j < N; j = j + 1)
+	{
+		a[i * N + j] = (double)(i - j) / (double)N;
+		b[i * N + j] = (double)(i + j) / (double)N;
+	}
+
+	matmul(a, b, c);
+
+	double sum = 0.0;
+	for(int i = 0; i < N * N; i = i + 1) sum = sum + c[i];
+	printf("%.6f\n", sum);
+
+	free(a); free(b); free(c);
+	return 0;
+}
@@ -0,0 +1,119 @@
+// n-body: simulates the orbits of the jovian planets
+// (after the computer language benchmarks game, evi twin: nbody.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define STEPS 5000000
+#define BODIES 5
+#define SOLAR_MASS (4.0 * M_PI * M_PI)
+#define DAYS_PER_YEAR 365.24
+
+// the properties of the bodies, one array each
+double *x, *y, *z;
+double *vx, *vy, *vz;
+double *mass;
+
+void init_body(int i, double px, double py, double pz, double pvx, double pvy, double pvz, double pmass)
+{
+	x[i] = px;
+	y[i] = py;
+	z[i] = pz;
+	vx[i] = pvx * DAYS_PER_YEAR;
+	vy[i] = pvy * DAYS_PER_YEAR;
+	vz[i] = pvz * DAYS_PER_YEAR;
+	mass[i] = pmass * SOLAR_MASS;
+}
+
+void offset_momentum()
+{
+	double px = 0.0, py = 0.0, pz = 0.0;
+	for(int i = 0; i < BODIES; i = i + 1)
+	{
+		px = px + vx[i] * mass[i];
+		py = py + vy[i] * mass[i];
+		pz = pz + vz[i] * mass[i];
+	}
+	vx[0] = -px / SOLAR_MASS;
+	vy[0] = -py / SOLAR_MASS;
+	vz[0] = -pz / SOLAR_MASS;
+}
+
+double energy()
+{
+	double e = 0.0;
+	for(int i = 0; i < BODIES; i = i + 1)
+	{
+		e = e + 0.5 * mass[i] * (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+		for(int j = i + 1; j < BODIES; j = j + 1)
+		{
+			double dx = x[i] - x[j];
+			double dy = y[i] - y[j];
+			double dz = z[i] - z[j];
+			e = e - mass[i] * mass[j] / sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	}
+	return e;
+}
+
+// advances the system by the given time step
+void advance(double dt)
+{
+	for(int i = 0; i < BODIES; i = i + 1)
+	{
+		for(int j = i + 1; j < BODIES; j = j + 1)
+		{
+			double dx = x[i] - x[j];
+			double dy = y[i] - y[j];
+			double dz = z[i] - z[j];
+			double dist2 = dx * dx + dy * dy + dz * dz;
+			double mag = dt / (dist2 * sqrt(dist2));
+
+			vx[i] = vx[i] - dx * mass[j] * mag;
+			vy[i] = vy[i] - dy * mass[j] * mag;
+			vz[i] = vz[i] - dz * mass[j] * mag;
+			vx[j] = vx[j] + dx * mass[i] * mag;
+			vy[j] = vy[j] + dy * mass[i] * mag;
+			vz[j] = vz[j] + dz * mass[i] * mag;
+		}
+	}
+	for(int i = 0; i < BODIES; i = i + 1)
+	{
+		x[i] = x[i] + dt * vx[i];
+		y[i] = y[i] + dt * vy[i];
+		z[i] = z[i] + dt * vz[i];
+	}
+}
+
+int main()
+{
+	x = (double*)malloc(sizeof(double) * BODIES);
+	y = (double*)malloc(sizeof(double) * BODIES);
+	z = (double*)malloc(sizeof(double) * BODIES);
+	vx = (double*)malloc(sizeof(double) * BODIES);
+	vy = (double*)malloc(sizeof(double) * BODIES);
+	vz = (double*)malloc(sizeof(double) * BODIES);
+	mass = (double*)malloc(sizeof(double) * BODIES);
+
+	// sun, jupiter, saturn, uranus and neptune
+	init_body(0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+	init_body(1, 4.84143144246472090, -1.16032004402742839, -0.103622044471123109,
+		0.00166007664274403694, 0.00769901118419740425, -0.0000690460016972063023, 0.000954791938424326609);
+	init_body(2, 8.34336671824457987, 4.12479856412430479, -0.403523417114321381,
+		-0.00276742510726862411, 0.00499852801234917238, 0.0000230417297573763929, 0.000285885980666130812);
+	init_body(3, 12.8943695621391310, -15.1111514016986312, -0.223307578892655734,
+		0.00296460137564761618, 0.00237847173959480950, -0.0000296589568540237556, 0.0000436624404335156298);
+	init_body(4, 15.3796971148509165, -25.9193146099879641, 0.179258772950371181,
+		0.00268067772490389322, 0.00162824170038242295, -0.0000951592254519715870, 0.0000515138902046611451);
+	offset_momentum();
+
+	printf("%.9f\n", energy());
+	for(int i = 0; i < STEPS; i = i + 1) advance(0.01);
+	printf("%.9f\n", energy());
+
+	free(x); free(y); free(z);
+	free(vx); free(vy); free(vz);
+	free(mass);
+	return 0;
+}
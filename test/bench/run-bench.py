@@ -0,0 +1,137 @@
+#!/usr/bin/python3
+# builds each kernel in this directory with evi and its c twin with clang at every
+# optimization level, then records the runtime, binary size and instruction count
+# usage: run-bench.py EVI CC OUTPUT_DIRECTORY [KERNEL...]
+# writes OUTPUT_DIRECTORY/runtime-bench.json and exits with 1 if evi is more than
+# EVI_BENCH_THRESHOLD (default 1.25) times slower than c for any kernel
+
+from sys import argv, exit
+from os import path
+from datetime import datetime
+import os, json, shutil, subprocess, time
+
+SCRIPT_DIR = path.dirname(path.realpath(__file__))
+ROOT_DIR = path.realpath(path.join(SCRIPT_DIR, "../.."))
+STDLIB_HEADERS = path.join(ROOT_DIR, "stdlib", "headers")
+KERNELS = ["nbody", "spectral-norm", "mandelbrot", "fannkuch", "sieve", "matmul", "strhash"]
+LEVELS = ["0", "1", "2", "3", "s", "z"]
+REPETITIONS = 5
+THRESHOLD = float(os.environ.get("EVI_BENCH_THRESHOLD", 1.25))
+
+# ============================
+
+def git_commit():
+	try: return subprocess.check_output(["git", "-C", ROOT_DIR, "rev-parse", "HEAD"], text=True).strip()
+	except Exception: return None
+
+def build(command):
+	result = subprocess.run(command, capture_output=True, text=True)
+	if result.returncode:
+		print(result.stderr)
+		print(f"[runtime-bench] \"{' '.join(command)}\" failed with code {result.returncode}")
+		exit(1)
+
+def build_evi(evi, kernel, level, output):
+	build([evi, path.join(SCRIPT_DIR, kernel + ".evi"), "-i", STDLIB_HEADERS,
+		   f"-O{level}", "-o", output, "--no-cache"])
+
+def build_c(cc, kernel, level, output):
+	# evi never contracts floating point operations, so neither may clang
+	# or the results of the twins would not be comparable
+	build([cc, path.join(SCRIPT_DIR, kernel + ".c"), f"-O{level}",
+		   "-ffp-contract=off", "-o", output, "-lm"])
+
+def count_instructions(binary):
+	# perf is optional, the instruction count is just left out without it
+	if not shutil.which("perf"): return None
+	result = subprocess.run(["perf", "stat", "-x", ",", "-e", "instructions:u", binary],
+							capture_output=True, text=True)
+	for line in result.stderr.splitlines():
+		fields = line.split(",")
+		if len(fields) > 2 and fields[2].startswith("instructions") and fields[0].isdigit():
+			return int(fields[0])
+	return None
+
+def measure(binary):
+	# the fastest run is the least disturbed by the rest of the system
+	times = []
+	for _ in range(REPETITIONS):
+		start = time.perf_counter()
+		result = subprocess.run([binary], capture_output=True, text=True)
+		times.append(time.perf_counter() - start)
+
+		if result.returncode:
+			print(f"[runtime-bench] \"{binary}\" failed with code {result.returncode}")
+			exit(1)
+
+	return {
+		"time_ms": min(times) * 1e3,
+		"size": path.getsize(binary),
+		"instructions": count_instructions(binary),
+		"output": result.stdout,
+	}
+
+def bench_kernel(evi, cc, directory, kernel, level):
+	evi_binary = path.join(directory, f"{kernel}-evi-O{level}")
+	c_binary = path.join(directory, f"{kernel}-c-O{level}")
+	build_evi(evi, kernel, level, evi_binary)
+	build_c(cc, kernel, level, c_binary)
+
+	evi_result = measure(evi_binary)
+	c_result = measure(c_binary)
+	ratio = evi_result["time_ms"] / c_result["time_ms"] if c_result["time_ms"] else None
+
+	return {
+		"kernel": kernel,
+		"level": f"O{level}",
+		"evi": evi_result,
+		"c": c_result,
+		"ratio": ratio,
+		"output_matches": evi_result["output"] == c_result["output"],
+		"slow": ratio is not None and ratio > THRESHOLD,
+	}
+
+def print_result(result):
+	evi, c = result["evi"], result["c"]
+	flags = ("  SLOW" if result["slow"] else "") + ("  WRONG OUTPUT" if not result["output_matches"] else "")
+	print(f"  {result['kernel']:<14} -{result['level']:<3} evi {evi['time_ms']:>10.2f} ms {evi['size']:>9} B"
+		  f"   c {c['time_ms']:>10.2f} ms {c['size']:>9} B   {result['ratio']:>5.2f}x{flags}")
+
+# ============================
+
+if __name__ == "__main__":
+	if len(argv) < 4 or not all(k in KERNELS for k in argv[4:]):
+		print("usage: run-bench.py EVI CC OUTPUT_DIRECTORY [KERNEL...]")
+		print(f"kernels: {', '.join(KERNELS)}")
+		exit(1)
+
+	evi = path.realpath(argv[1])
+	cc = argv[2]
+	directory = argv[3]
+	kernels = argv[4:] or KERNELS
+	os.makedirs(directory, exist_ok=True)
+
+	results = []
+	for kernel in kernels:
+		for level in LEVELS:
+			results.append(bench_kernel(evi, cc, directory, kernel, level))
+			print_result(results[-1])
+
+	output = path.join(directory, "runtime-bench.json")
+	with open(output, "w") as f:
+		json.dump({
+			"commit": git_commit(),
+			"date": datetime.now().isoformat(),
+			"compiler": cc,
+			"repetitions": REPETITIONS,
+			"threshold": THRESHOLD,
+			"results": results
+		}, f, indent=4)
+	print(f"[runtime-bench] Results written to \"{output}\"")
+
+	failed = [r for r in results if r["slow"] or not r["output_matches"]]
+	for r in failed:
+		reason = "gave a different output than c" if not r["output_matches"] \
+			else f"is {r['ratio']:.2f}x slower than c (threshold {THRESHOLD:.2f}x)"
+		print(f"[runtime-bench] {r['kernel']} at -{r['level']} {reason}")
+	exit(1 if failed else 0)
@@ -0,0 +1,34 @@
+// sieve: counts the primes below LIMIT with the sieve of eratosthenes, ROUNDS times
+// (evi twin: sieve.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LIMIT 10000000
+#define ROUNDS 5
+
+int sieve(unsigned char* flags)
+{
+	for(int i = 0; i < LIMIT; i = i + 1) flags[i] = 1;
+	flags[0] = 0;
+	flags[1] = 0;
+
+	for(int i = 2; i * i < LIMIT; i = i + 1)
+		if(flags[i] != 0) for(int j = i * i; j < LIMIT; j = j + i) flags[j] = 0;
+
+	int count = 0;
+	for(int i = 0; i < LIMIT; i = i + 1) if(flags[i] != 0) count = count + 1;
+	return count;
+}
+
+int main()
+{
+	unsigned char* flags = (unsigned char*)malloc(LIMIT);
+	int count = 0;
+	for(int i = 0; i < ROUNDS; i = i + 1) count = sieve(flags);
+
+	printf("%d\n", count);
+
+	free(flags);
+	return 0;
+}
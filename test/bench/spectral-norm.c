@@ -0,0 +1,67 @@
+// spectral-norm: approximates the spectral norm of an infinite matrix
+// (after the computer language benchmarks game, evi twin: spectral-norm.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define N 2000
+#define ITERATIONS 10
+
+// element (i, j) of the matrix
+double eval_a(int i, int j)
+{
+	return 1.0 / (double)((i + j) * (i + j + 1) / 2 + i + 1);
+}
+
+// av = A * v
+void mul_av(double* v, double* av)
+{
+	for(int i = 0; i < N; i = i + 1)
+	{
+		double sum = 0.0;
+		for(int j = 0; j < N; j = j + 1) sum = sum + eval_a(i, j) * v[j];
+		av[i] = sum;
+	}
+}
+
+// atv = A^T * v
+void mul_atv(double* v, double* atv)
+{
+	for(int i = 0; i < N; i = i + 1)
+	{
+		double sum = 0.0;
+		for(int j = 0; j < N; j = j + 1) sum = sum + eval_a(j, i) * v[j];
+		atv[i] = sum;
+	}
+}
+
+// atav = A^T * A * v
+void mul_atav(double* v, double* atav, double* tmp)
+{
+	mul_av(v, tmp);
+	mul_atv(tmp, atav);
+}
+
+int main()
+{
+	double *u = (double*)malloc(sizeof(double) * N), *v = (double*)malloc(sizeof(double) * N), *tmp = (double*)malloc(sizeof(double) * N);
+	for(int i = 0; i < N; i = i + 1) u[i] = 1.0;
+
+	for(int i = 0; i < ITERATIONS; i = i + 1)
+	{
+		mul_atav(u, v, tmp);
+		mul_atav(v, u, tmp);
+	}
+
+	double vbv = 0.0, vv = 0.0;
+	for(int i = 0; i < N; i = i + 1)
+	{
+		vbv = vbv + u[i] * v[i];
+		vv = vv + v[i] * v[i];
+	}
+	printf("%.9f\n", sqrt(vbv / vv));
+
+	free(u); free(v); free(tmp);
+	return 0;
+}
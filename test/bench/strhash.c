@@ -0,0 +1,36 @@
+// strhash: hashes a pseudo-random string with 32-bit FNV-1a, ROUNDS times
+// (evi twin: strhash.evi)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LENGTH 1048576
+#define ROUNDS 200
+#define FNV_OFFSET 0x811c9dc5u
+#define FNV_PRIME 16777619u
+
+unsigned fnv1a(unsigned char* str, unsigned round)
+{
+	unsigned hash = FNV_OFFSET ^ round;
+	for(int i = 0; i < LENGTH; i = i + 1) hash = (hash ^ (unsigned)str[i]) * FNV_PRIME;
+	return hash;
+}
+
+int main()
+{
+	// fill the string with printable characters from a linear congruential generator
+	unsigned char* str = (unsigned char*)malloc(LENGTH);
+	unsigned seed = 42;
+	for(int i = 0; i < LENGTH; i = i + 1)
+	{
+		seed = seed * 1103515245u + 12345u;
+		str[i] = (unsigned char)(((seed >> 16) & 63) + 32);
+	}
+
+	unsigned total = 0;
+	for(unsigned i = 0; i < ROUNDS; i = i + 1) total = total ^ fnv1a(str, i);
+	printf("%u\n", total);
+
+	free(str);
+	return 0;
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/python3
+# measures the compile throughput of each compiler phase on synthetic programs
+# usage: compile-bench.py EVI OUTPUT_DIRECTORY [--long-names] [SIZE...]
+# writes OUTPUT_DIRECTORY/compile-bench.json
+# the scanner's simd kernels can be compared by running it again with EVI_SIMD=scalar
+
+from sys import argv, exit
+from os import path
+from statistics import median
+from datetime import datetime
+import os, json, subprocess
+
+SCRIPT_DIR = path.dirname(path.realpath(__file__))
+ROOT_DIR = path.realpath(path.join(SCRIPT_DIR, "../.."))
+GENERATOR = path.join(SCRIPT_DIR, "generate-program.py")
+DEFAULT_SIZES = [10, 100, 1000]
+REPETITIONS = 5
+
+# ============================
+
+def git_commit():
+	try: return subprocess.check_output(["git", "-C", ROOT_DIR, "rev-parse", "HEAD"], text=True).strip()
+	except Exception: return None
+
+def compile_once(evi, directory):
+	# -c so that only the compiler itself is measured, not the linker
+	command = [evi, path.join(directory, "main.evi"), "-i", path.join(directory, "headers"),
+			   "-c", "-o", path.join(directory, "main.o"), "--no-cache", "--time-phases=json"]
+	result = subprocess.run(command, capture_output=True, text=True)
+	if result.returncode:
+		print(result.stderr)
+		print(f"[compile-bench] \"{' '.join(command)}\" failed with code {result.returncode}")
+		exit(1)
+
+	# the timings are the last line of the output
+	return json.loads(result.stdout.strip().splitlines()[-1])
+
+def bench_size(evi, directory, size, long_names):
+	program_dir = path.join(directory, f"program-{size}" + ("-long-names" if long_names else ""))
+	subprocess.run(["python3", GENERATOR, str(size), program_dir] + (["--long-names"] if long_names else []), check=True)
+	lines = sum(1 for _ in open(path.join(program_dir, "main.evi")))
+
+	# median of each phase over the repetitions
+	runs = [compile_once(evi, program_dir) for _ in range(REPETITIONS)]
+	phases = {}
+	for timing in runs[0]["phases"]:
+		name = timing["phase"]
+		samples = [t for run in runs for t in run["phases"] if t["phase"] == name]
+		wall_ms = median(t["wall_ms"] for t in samples)
+
+		phases[name] = {
+			"wall_ms": wall_ms,
+			"cpu_ms": median(t["cpu_ms"] for t in samples),
+		}
+		if "unit" in timing:
+			phases[name]["units"] = timing["units"]
+			phases[name]["unit"] = timing["unit"]
+			phases[name]["units_per_sec"] = timing["units"] / (wall_ms / 1e3) if wall_ms else None
+
+	peak_rss_kb = median(run["peak_rss_kb"] for run in runs)
+	return {"size": size, "lines": lines, "long_names": long_names, "simd": runs[0].get("simd"),
+			"peak_rss_kb": peak_rss_kb, "phases": phases}
+
+def print_result(result):
+	print(f"[compile-bench] size {result['size']} ({result['lines']} lines, simd: {result['simd']}):")
+	for name, phase in result["phases"].items():
+		throughput = f"{phase['units_per_sec']:.0f} {phase['unit']}/s" if phase.get("units_per_sec") else ""
+		print(f"  {name:<12} {phase['wall_ms']:>12.3f} ms {throughput:>26}")
+
+# ============================
+
+if __name__ == "__main__":
+	long_names = "--long-names" in argv
+	args = [arg for arg in argv[1:] if arg != "--long-names"]
+	if len(args) < 2 or not all(s.isdigit() for s in args[2:]):
+		print("usage: compile-bench.py EVI OUTPUT_DIRECTORY [--long-names] [SIZE...]")
+		exit(1)
+
+	evi = path.realpath(args[0])
+	directory = args[1]
+	sizes = [int(s) for s in args[2:]] or DEFAULT_SIZES
+	os.makedirs(directory, exist_ok=True)
+
+	results = []
+	for size in sizes:
+		results.append(bench_size(evi, directory, size, long_names))
+		print_result(results[-1])
+
+	output = path.join(directory, "compile-bench.json")
+	with open(output, "w") as f:
+		json.dump({
+			"commit": git_commit(),
+			"date": datetime.now().isoformat(),
+			"repetitions": REPETITIONS,
+			"results": results
+		}, f, indent=4)
+	print(f"[compile-bench] Results written to \"{output}\"")
@@ -0,0 +1,120 @@
+#!/usr/bin/python3
+# generates a synthetic evi program for benchmarking the compiler
+# usage: generate-program.py SIZE DIRECTORY [--long-names]
+# writes DIRECTORY/main.evi and its headers to DIRECTORY/headers/
+# --long-names uses long identifiers and adds string literals (for the scanner)
+
+from sys import argv, exit
+from os import path
+import os, random
+
+HEADER_FANOUT = 3 # amount of headers each header applies
+EXPR_DEPTH = 5 # depth of the balanced expression trees
+NESTING_DEPTH = 32 # depth of the right-nested expressions
+ARRAY_SIZE = 64 # length of the array literals
+OPERATORS = ["+", "-", "*", "&", "|", "^"]
+FLAT_LENGTH = 48 # amount of operators in the unparenthesized expressions
+FLAT_OPERATORS = OPERATORS + ["/", "<<", ">>"]
+NAME_WORDS = ["buffer", "index", "length", "count", "value", "result", "offset",
+			  "element", "source", "target", "temporary", "accumulated", "position"]
+STRING_WORDS = 24 # amount of words in the string literals
+long_names = False
+
+# ============================
+
+def header_name(i):
+	return f"bench_h{i}"
+
+def expression(depth, leaves):
+	if depth == 0: return random.choice(leaves)
+	return f"({expression(depth - 1, leaves)} {random.choice(OPERATORS)} {expression(depth - 1, leaves)})"
+
+def nested_expression(depth, leaves):
+	if depth == 0: return random.choice(leaves)
+	return f"({random.choice(leaves)} {random.choice(OPERATORS)} {nested_expression(depth - 1, leaves)})"
+
+def flat_expression(length, leaves):
+	# no parentheses, so the parser has to resolve the precedence itself
+	expr = random.choice(leaves)
+	for _ in range(length):
+		leaf = random.choice(leaves)
+		if random.random() < 0.2: leaf = f"-{leaf}"
+		expr += f" {random.choice(FLAT_OPERATORS)} {leaf}"
+	return expr
+
+def long_name(i):
+	# a few words picked by i, so the same i gives the same name
+	words = [NAME_WORDS[(i // len(NAME_WORDS) ** k) % len(NAME_WORDS)] for k in range(4)]
+	return "_".join(words) + f"_{i}"
+
+def function_name(i):
+	return f"fn_{long_name(i)}" if long_names else f"fn_{i}"
+
+def generate_header(i, headerc):
+	lines = [f"\\ synthetic header {i}", "#info apply_once", ""]
+
+	# forward edges only, apply_once keeps the graph from exploding
+	for j in range(i + 1, min(i + 1 + HEADER_FANOUT, headerc)):
+		lines.append(f"#apply \"{header_name(j)}\"")
+
+	lines.append("")
+	lines.append(f"#macro SCALE_{i} {random.randint(1, 100)}")
+	lines.append(f"#macro MIX_{i} (SCALE_{i}# * 3 + {i})")
+	lines.append("")
+	lines.append(f"@hfn_{i} i32 (i32) ~ $0 * MIX_{i}# + SCALE_{i}#;")
+	return "\n".join(lines) + "\n"
+
+def generate_function(i, headerc):
+	h = random.randrange(headerc)
+	a, b = (f"first_{long_name(i)}", f"second_{long_name(i + 1)}") if long_names else ("a", "b")
+	leaves = ["$0", "$1", f"${a}", f"${b}", str(random.randint(1, 1000)), f"MIX_{h}#", f"SCALE_{h}#"]
+	array = ", ".join(str(random.randint(0, 1000)) for _ in range(ARRAY_SIZE))
+
+	lines = [
+		f"@{function_name(i)} i32 (i32 i32)",
+		"{",
+		f"\t%{a}, {b} i32 $0 + SCALE_{h}#, $1 - MIX_{h}#;",
+		f"\t%arr i32* {{{array}}};",
+		"",
+		f"\t!!(%j i32 0; $j < {ARRAY_SIZE}; =j $j + 1;)",
+		f"\t\t={a} ${a} + $arr[$j] * MIX_{h}#;",
+		"",
+		f"\t?? (${a} > ${b}) ={b} {expression(EXPR_DEPTH, leaves)};",
+		f"\t:: ={b} {expression(EXPR_DEPTH, leaves)};",
+		"",
+		f"\t={a} hfn_{h}(${a}) + {f'{function_name(i - 1)}(${a}, ${b})' if i else '0'};",
+		f"\t={b} {nested_expression(NESTING_DEPTH, leaves)};",
+		f"\t={a} {flat_expression(FLAT_LENGTH, leaves)};",
+		f"\t~ {expression(EXPR_DEPTH, leaves)};",
+		"}",
+	]
+	if long_names:
+		text = " ".join(random.choice(NAME_WORDS) for _ in range(STRING_WORDS))
+		lines.insert(2, f"\t%message chr* \"{text}\";")
+	return "\n".join(lines) + "\n"
+
+def generate_program(size, directory):
+	headerc = max(1, size // 10)
+	os.makedirs(path.join(directory, "headers"), exist_ok=True)
+
+	for i in range(headerc):
+		with open(path.join(directory, "headers", header_name(i) + ".hevi"), "w") as f:
+			f.write(generate_header(i, headerc))
+
+	with open(path.join(directory, "main.evi"), "w") as f:
+		f.write(f"\\ synthetic program of size {size}\n")
+		f.write(f"#apply \"{header_name(0)}\"\n\n")
+		for i in range(size): f.write(generate_function(i, headerc) + "\n")
+		f.write(f"@main i32 () ~ {function_name(size - 1)}(1, 2) & 255;\n")
+
+# ============================
+
+if __name__ == "__main__":
+	long_names = "--long-names" in argv
+	args = [arg for arg in argv[1:] if arg != "--long-names"]
+	if len(args) != 2 or not args[0].isdigit() or int(args[0]) < 1:
+		print("usage: generate-program.py SIZE DIRECTORY [--long-names]")
+		exit(1)
+
+	random.seed(int(args[0])) # same size, same program
+	generate_program(int(args[0]), args[1])
@@ -0,0 +1,73 @@
+#!/usr/bin/python3
+# measures the macro expansion of the preprocessor on a generated program
+# usage: macro-bench.py EVI OUTPUT_DIRECTORY [LINES]
+# writes OUTPUT_DIRECTORY/macros.evi and OUTPUT_DIRECTORY/macro-bench.json
+
+from sys import argv, exit
+from os import path
+from statistics import median
+from datetime import datetime
+import os, json, subprocess
+
+SCRIPT_DIR = path.dirname(path.realpath(__file__))
+ROOT_DIR = path.realpath(path.join(SCRIPT_DIR, "../.."))
+DEFAULT_LINES = 100000
+REPETITIONS = 5
+
+# ============================
+
+def git_commit():
+	try: return subprocess.check_output(["git", "-C", ROOT_DIR, "rev-parse", "HEAD"], text=True).strip()
+	except Exception: return None
+
+def generate_program(lines, file):
+	# two invocations per line, one of them expands another macro
+	with open(file, "w") as f:
+		f.write(f"\\ {lines} lines of macro invocations\n")
+		f.write("#macro SCALE 3\n")
+		f.write("#macro MIX (SCALE# * 7 + 1)\n\n")
+		f.write("@main i32 ()\n{\n\t%a i32 0;\n")
+		for i in range(lines): f.write(f"\t=a $a + SCALE# * MIX# - {i};\n")
+		f.write("\t~ $a;\n}\n")
+
+def preprocess_once(evi, file, directory):
+	# -E so that only the preprocessor runs
+	command = [evi, file, "-E", "-o", path.join(directory, "macros.evii"), "--no-cache", "--time-phases=json"]
+	result = subprocess.run(command, capture_output=True, text=True)
+	if result.returncode:
+		print(result.stderr)
+		print(f"[macro-bench] \"{' '.join(command)}\" failed with code {result.returncode}")
+		exit(1)
+
+	# the timings are the last line of the output
+	timings = json.loads(result.stdout.strip().splitlines()[-1])
+	return next(t["wall_ms"] for t in timings["phases"] if t["phase"] == "preprocess")
+
+# ============================
+
+if __name__ == "__main__":
+	if len(argv) not in [3, 4] or (len(argv) == 4 and not argv[3].isdigit()):
+		print("usage: macro-bench.py EVI OUTPUT_DIRECTORY [LINES]")
+		exit(1)
+
+	evi = path.realpath(argv[1])
+	directory = argv[2]
+	lines = int(argv[3]) if len(argv) == 4 else DEFAULT_LINES
+	os.makedirs(directory, exist_ok=True)
+
+	file = path.join(directory, "macros.evi")
+	generate_program(lines, file)
+
+	wall_ms = median(preprocess_once(evi, file, directory) for _ in range(REPETITIONS))
+	print(f"[macro-bench] {lines} lines: preprocess {wall_ms:.3f} ms ({lines / (wall_ms / 1e3):.0f} lines/s)")
+
+	output = path.join(directory, "macro-bench.json")
+	with open(output, "w") as f:
+		json.dump({
+			"commit": git_commit(),
+			"date": datetime.now().isoformat(),
+			"repetitions": REPETITIONS,
+			"lines": lines,
+			"wall_ms": wall_ms,
+		}, f, indent=4)
+	print(f"[macro-bench] Results written to \"{output}\"")
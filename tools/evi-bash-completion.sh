@@ -9,7 +9,7 @@ _evi_autocomplete()
         -h|--help|--usage|-V|--version)
             return
             ;;
-        -l|--link|-o|--output)
+        -l|--link|-o|--output|--time-trace|--profile-use)
             _filedir
             return
             ;;